@@ -0,0 +1,97 @@
+
+#include "msp.h"
+#include "Bumpers.h"
+#include "MotionProfile.h"
+#include "Motor.h"
+#include "Timebase.h"
+#include "Probe.h"
+#include "RamFunc.h"
+#include "Ring.h"
+
+// The six bump switches on the front of the RSLK, right to left: P4.0, P4.2, P4.3, P4.5, P4.6 and P4.7.
+// Each closes to ground when it touches something.
+#define BUMP_PINS 0xED
+#define ENTRY_CYCLES 12 // nominal cycles the Cortex-M4 takes to stack registers and reach a handler (no wait states or late arrival)
+#define QUEUE 4 // collisions that can wait for the main loop; a power of two
+
+static struct BumpEvent events[QUEUE]; // queued by PORT4_IRQHandler
+static struct Ring queue = RING_INIT(QUEUE);
+static volatile uint32_t worstCycles; // longest time from entering PORT4_IRQHandler to both motors being off, plus ENTRY_CYCLES
+
+// Initializes the bump switches to interrupt, at the highest priority, when any of them is pressed.
+void Bumpers_Init(void)
+{
+    P4->SEL0 &= ~BUMP_PINS;
+    P4->SEL1 &= ~BUMP_PINS; // GPIO
+    P4->DIR &= ~BUMP_PINS; // inputs
+    P4->REN |= BUMP_PINS; // activate pull resistors
+    P4->OUT |= BUMP_PINS; // make the pull resistors pull-up
+
+    P4->IES |= BUMP_PINS; // falling edge (touch)
+    P4->IFG &= ~BUMP_PINS; // clear interrupt flags
+    P4->IE |= BUMP_PINS; // arm interrupts on the switches
+    NVIC->IP[38] = 0x00; // priority 0: nothing else can hold the motors on
+    NVIC->ISER[1] = 0x00000040; // enable interrupt 38 in NVIC
+}
+
+// Returns the switches pressed right now, in the same bit order as BumpEvent.switches.
+uint8_t Bumpers_Read(void)
+{
+    uint8_t in = ~P4->IN;
+    return (in & 0x01) | ((in >> 1) & 0x06) | ((in >> 2) & 0x38);
+}
+
+// Cuts the motors on a collision and queues a BumpEvent for the main loop.
+// The motors stay halted until the main loop calls Motor_Release, and only the hit that halts them is
+// queued, so switch bounce and the robot rocking against the wall don't flood the queue.
+RAMFUNC void PORT4_IRQHandler(void)
+{
+    uint32_t start = DWT->CYCCNT;
+    uint8_t wasHalted = Motor_Halt(); // first, before anything else
+    uint32_t cycles = DWT->CYCCNT - start + ENTRY_CYCLES;
+    PROBE_BEGIN(PROBE_BUMPER_ISR);
+    P4->IFG &= ~BUMP_PINS; // acknowledge the interrupt
+    if (cycles > worstCycles)
+    {
+        worstCycles = cycles;
+    }
+    if (!wasHalted)
+    {
+        int16_t slot = Ring_Reserve(&queue);
+        if (slot >= 0)
+        {
+            events[slot].time = Timebase_NowUs();
+            events[slot].switches = Bumpers_Read();
+            Ring_Publish(&queue);
+        }
+    }
+    PROBE_END(PROBE_BUMPER_ISR);
+}
+
+// Stores the oldest collision not yet handled in "event" and returns 1, or returns 0 if there is none.
+uint8_t Bumpers_Next(struct BumpEvent *event)
+{
+    int16_t slot = Ring_Front(&queue);
+    if (slot < 0)
+    {
+        return 0;
+    }
+    *event = events[slot];
+    Ring_Pop(&queue);
+    return 1;
+}
+
+// Returns the longest time, in cycles, the handler took to get both motors off over every hit so far, measured
+// from its first instruction, plus the nominal ENTRY_CYCLES for the exception entry. It is not the edge-to-off
+// time: a port pin has no capture to timestamp the edge, so the input synchronizer, time spent with interrupts
+// disabled and any extra entry cycles (flash wait states, a late-arriving exception) aren't in it.
+uint32_t Bumpers_HaltCycles(void)
+{
+    return worstCycles;
+}
+
+// Returns the number of collisions dropped because the main loop didn't handle them in time.
+uint16_t Bumpers_Overruns(void)
+{
+    return queue.overruns;
+}
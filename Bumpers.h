@@ -0,0 +1,18 @@
+#ifndef BUMPERS_H
+#define BUMPERS_H
+
+// A collision, as the bumper interrupt saw it.
+struct BumpEvent
+{
+    uint32_t time; // Timebase_NowUs when the motors were cut
+    uint8_t switches; // which switches were pressed: bit 0 is the right-most (BUMP0) to bit 5 the left-most (BUMP5)
+};
+
+void Bumpers_Init(void);
+uint8_t Bumpers_Read(void);
+uint8_t Bumpers_Next(struct BumpEvent *event);
+uint32_t Bumpers_HaltCycles(void);
+uint16_t Bumpers_Overruns(void);
+void PORT4_IRQHandler(void);
+
+#endif
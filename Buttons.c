@@ -5,6 +5,16 @@
 #include "Globals.c"
 #include "GenInterrupts.h"
 #include "TimerAs.h"
+#include "TimerWheel.h"
+#include "Probe.h"
+#include "RamFunc.h"
+#include "Ring.h"
+
+#define DEBOUNCE_MS 20 // how long the buttons are ignored after a press, while the contacts bounce
+#define QUEUE 4 // presses that can wait for the main loop; a power of two
+
+static uint8_t presses[QUEUE]; // P1 interrupt flags of each press, queued by PORT1_IRQHandler
+static struct Ring queue = RING_INIT(QUEUE);
 
 // Initializes the left and right buttons to send an interrupt when one is pressed
 void OnBoardButtons_Init()
@@ -27,42 +37,77 @@ void OnBoardButtons_Init()
     NVIC->ISER[1] |= 0x00000008; // enable interrupt #35
 }
 
-// Handles a button being pressed.
+// Listens to the buttons again once the debounce time is over.
+static void OnBoardButtons_Rearm(void)
+{
+    P1->IFG &= ~0x12; // forget the bounces
+    P1->IE |= 0x12; // arm interrupt on button
+}
+
+// Handles a button being pressed by queueing it for OnBoardButtons_Handle.
 void PORT1_IRQHandler(void)
 {
+    PROBE_BEGIN(PROBE_BUTTON_ISR);
     uint8_t iFlags = P1->IFG; // store the interrupt flag to know which button was pressed
     P1->IFG &= ~0x12; // clear the switch's interrupt flag (acknowledge interrupt)
-    if (iFlags & 0x02) // if the left button was pressed
+    P1->IE &= ~0x12; // ignore the buttons while they bounce
+    if (SoftTimer_Start(OnBoardButtons_Rearm, DEBOUNCE_MS, 0) == TIMERWHEEL_NONE) // no timer free to re-arm them
     {
-        if ((state == STOPPED) || (state == WIN)) // if the robot was stopped when the button was pressed
-        {
-            // Restart the maze solving as if it's a new maze
-            state = RUNNING; // set the state to RUNNING to run the maze solver again (not show the solution)
-        }
-        else // if the robot was solving the maze (RUNNING) or showing the solution (SOLUTIONING)
-        {
-            state = STOPPED; // set the robot's state to stopped
-        }
+        P1->IE |= 0x12; // so go without debouncing rather than lose the buttons
     }
-    else // the right button was pressed
+    int16_t slot = Ring_Reserve(&queue);
+    if (slot >= 0) // if main hasn't kept up, the press is dropped (and counted)
     {
-        if ((state == STOPPED) || (state == WIN)) // if the robot was stopped when the button was pressed
-        {
-            // Show how to solve the maze, which may or may not have been fully solved
-            state = RUNNING; // set the state to RUNNING to run the maze solver again (not show the solution)
+        presses[slot] = iFlags;
+        Ring_Publish(&queue);
+    }
+    PROBE_END(PROBE_BUTTON_ISR);
+}
 
-        }
-        else if (state == SOLUTIONING) // if the robot was showing the solution when the button was pressed
+// Changes the robot's state for each button press queued since the last call. Call from the main loop.
+void OnBoardButtons_Handle(void)
+{
+    int16_t slot;
+    while ((slot = Ring_Front(&queue)) >= 0)
+    {
+        uint8_t iFlags = presses[slot];
+        Ring_Pop(&queue);
+        if (iFlags & 0x02) // if the left button was pressed
         {
-            state = STOPPED; // set the robot's state to stopped
+            if ((state == STOPPED) || (state == WIN)) // if the robot was stopped when the button was pressed
+            {
+                // Restart the maze solving as if it's a new maze
+                state = RUNNING; // set the state to RUNNING to run the maze solver again (not show the solution)
+            }
+            else // if the robot was solving the maze (RUNNING) or showing the solution (SOLUTIONING)
+            {
+                state = STOPPED; // set the robot's state to stopped
+            }
         }
-        else // state == RUNNING
+        else // the right button was pressed
         {
-            return; // the robot shouldn't react to the right button being pressed if it's currently solving the maze
+            if ((state == STOPPED) || (state == WIN)) // if the robot was stopped when the button was pressed
+            {
+                // Show how to solve the maze, which may or may not have been fully solved
+                state = SOLUTIONING; // replay the way to the goal (main explores instead if there isn't one)
+            }
+            else if (state == SOLUTIONING) // if the robot was showing the solution when the button was pressed
+            {
+                state = STOPPED; // set the robot's state to stopped
+            }
+            else // state == RUNNING
+            {
+                continue; // the robot shouldn't react to the right button being pressed if it's currently solving the maze
+            }
         }
+        TimerA1_Stop(); // stop Timer A1 so the top LEDs stop flashing if they are flashing
+        SysTick_EnableInterrupt(); // re-enable the SysTick interrupt if it was disabled
+        SysTick_Restart(); // reload SysTick with 0.2 second timer
     }
-    TimerA0_Stop(); // stop Timer A0 so the top LEDs stop flashing if they are flashing
-    SysTick_EnableInterrupt(); // re-enable the SysTick interrupt if it was disabled
-    SysTick_Restart(); // reload SysTick with 0.2 second timer
-    EnableInterrupts(); // enable interrupts in general, though we shouldn't be here if they're disabled
+}
+
+// Returns the number of presses dropped because main didn't handle them in time.
+uint16_t OnBoardButtons_Overruns(void)
+{
+    return queue.overruns;
 }
@@ -2,3 +2,5 @@
 
 void OnBoardButtons_Init();
 void PORT1_IRQHandler(void);
+void OnBoardButtons_Handle(void);
+uint16_t OnBoardButtons_Overruns(void);
@@ -1,5 +1,6 @@
 #include "msp.h"
 #include "Clock.h"
+#include "Timebase.h"
 
 uint32_t ClockFrequency = 3000000; // clock speed, cycles/second. Default is 3MHz
 
@@ -93,35 +94,18 @@ void Clock_Init48MHz(void)
             0x00000050 | // configure for SMCLK and HSMCLK sourced from HFXTCLK
             0x00000005; // configure for MCLK sourced from HFXTCLK
     CS->KEY = 0; // lock CS module from unintended access
-    ClockFrequency = 48000000; // set the clock frequency for doing math later on (usually inside delay functions)
+    ClockFrequency = 48000000; // set the clock frequency for doing math later on
 }
 
-// delay function
-// which delays about 6*ulCount cycles
-// ulCount=8000 => 1ms = (8000 loops)*(6 cycles/loop)*(20.83 ns/cycle)
-// Code Composer Studio Code
-void delay(unsigned long ulCount)
-{
-    __asm ("pdloop:  subs r0, #1\n"
-           "         bne  pdloop\n");
-}
-
-// Simple delay function which delays about n milliseconds at 48MHz.
+// Delays n milliseconds, measured on the timebase, so it doesn't depend on compiler settings or flash wait states.
+// Interrupts that run during the delay don't lengthen it.
 void Clock_Delay1ms(uint32_t n)
 {
-    while (n) // while n > 0 (runs n times)
-    {
-        delay(ClockFrequency / 9162); // 1 msec, tuned at 48 MHz
-        n--; // decrement n so while-loop runs n times
-    }
+    Timebase_WaitUntil(Timebase_Deadline(1000 * n));
 }
 
-// Simple delay function which delays about n microseconds at 48MHz.
+// Delays n microseconds, measured on the timebase.
 void Clock_Delay1us(uint32_t n)
 {
-    n = (382*n) / 100;; // 1 us, tuned at 48 MHz
-    while (n) // while n > 0 (run n times)
-    {
-        n--; // decrement n so while-loop runs n times
-    }
+    Timebase_WaitUntil(Timebase_Deadline(n));
 }
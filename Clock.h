@@ -1,4 +1,3 @@
 void Clock_Init48MHz(void);
-void delay(unsigned long ulCount);
 void Clock_Delay1ms(uint32_t n);
 void Clock_Delay1us(uint32_t n);
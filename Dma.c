@@ -0,0 +1,14 @@
+
+#include "msp.h"
+#include "Dma.h"
+
+// Primary structures for the 8 channels, then the alternate ones, aligned to the table's size.
+struct DmaDescriptor dmaTable[16] __attribute__((aligned(256)));
+
+// Enables the DMA controller with its control table. Every module that uses a channel calls this
+// before setting the channel up; calling it again changes nothing.
+void Dma_Init(void)
+{
+    DMA_Control->CFG = 0x01; // enable the DMA controller
+    DMA_Control->CTLBASE = (uintptr_t)dmaTable;
+}
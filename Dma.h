@@ -0,0 +1,20 @@
+#ifndef DMA_H
+#define DMA_H
+
+// A uDMA channel control structure. The controller reads these from the table at CTLBASE.
+struct DmaDescriptor
+{
+    volatile void *srcEnd; // address of the last byte to read
+    volatile void *dstEnd; // address of the last byte to write
+    volatile uint32_t control;
+    uint32_t spare;
+};
+
+// The channels in use: each module sets up its own, with its primary structure in dmaTable.
+//   channel 0  Telemetry.c, feeding eUSCI_A0 TX (DMA_INT1)
+//   channel 4  LineSensor.c, sampling P7 on Timer A2 CCR0 (DMA_INT2)
+extern struct DmaDescriptor dmaTable[16];
+
+void Dma_Init(void);
+
+#endif
@@ -0,0 +1,218 @@
+
+#include "msp.h"
+#include "Encoder.h"
+#include "RamFunc.h"
+#include "Ring.h"
+#include "GenInterrupts.h"
+
+// Each wheel has a quadrature encoder. Channel A goes to a Timer A3 capture input, which
+// timestamps every rising edge; channel B is a plain input read in the interrupt to get the
+// direction. (P10 has no port interrupts, so the capture interrupt is the edge interrupt.)
+//   right wheel: A = P10.4 (TA3.CCI0A), B = P5.0
+//   left wheel:  A = P10.5 (TA3.CCI1A), B = P5.2
+// B is high on a rising edge of A when the wheel turns forward.
+//
+// Timer A3 runs continuously from SMCLK / 8 / 4 = 375kHz, so a 16-bit capture difference
+// measures edge periods up to 174ms (3.5mm/s). Slower than that the wheel counts as stopped.
+//
+// The interrupts only queue each edge's capture and direction; the main loop counts them when it
+// reads or updates the encoders, so nothing the interrupts touch is shared but the queue. The main
+// loop is the queues' only consumer: other interrupt handlers read the positions it last counted,
+// through Encoder_Position.
+#define COUNTS_PER_SEC 375000
+#define STALL_UPDATES (100 / ENCODER_PERIOD_MS) // no edge for 100ms means the wheel has stopped
+#define QUEUE 32 // edges that can wait for the main loop: 5ms at 3.9m/s; a power of two
+
+// Speed in mm/s for an edge period of "counts" timer counts.
+#define SPEED(counts) ((ENCODER_UM_PER_TICK * (COUNTS_PER_SEC / 1000)) / (counts))
+
+// One rising edge of channel A.
+struct Edge
+{
+    uint16_t capture; // timer count at the edge
+    uint8_t forward; // the level of channel B
+};
+
+struct Wheel
+{
+    struct Edge edges[QUEUE]; // filled by the interrupt
+    struct Ring queue;
+    int32_t ticks; // position, + forward
+    int32_t published; // ticks as of the last Encoder_Read or Encoder_Update, for Encoder_Position
+    int16_t moved; // edges since the last update, + forward
+    uint16_t timed; // how many of those have a valid period
+    uint32_t periodSum; // sum of those periods, in timer counts
+    uint16_t lastCapture; // timer count at the previous edge
+    uint8_t stalled; // the previous edge is too old to time the next one from
+    uint8_t idle; // updates in a row without an edge
+    int16_t speed; // mm/s, + forward
+};
+
+static struct Wheel left = { .queue = RING_INIT(QUEUE), .stalled = 1 };
+static struct Wheel right = { .queue = RING_INIT(QUEUE), .stalled = 1 };
+
+// Initializes the encoder inputs and Timer A3, and starts counting from 0.
+void Encoder_Init(void)
+{
+    P10->SEL0 |= 0x30; // primary module function (TA3.CCI0A and TA3.CCI1A)
+    P10->SEL1 &= ~0x30;
+    P10->DIR &= ~0x30; // inputs
+    P5->SEL0 &= ~0x05; // GPIO
+    P5->SEL1 &= ~0x05;
+    P5->DIR &= ~0x05; // inputs
+
+    TIMER_A3->CTL &= ~0x0030; // stop Timer A3
+    TIMER_A3->CCTL[0] = 0x4910; // capture on rising edge of CCI0A, synchronized, interrupt
+    TIMER_A3->CCTL[1] = 0x4910; // capture on rising edge of CCI1A, synchronized, interrupt
+    TIMER_A3->EX0 = 0x3; // divide by 4 more
+    NVIC->IP[14] = 0x40; // priority 2
+    NVIC->IP[15] = 0x40; // priority 2
+    NVIC->ISER[0] = 0x0000C000; // enable interrupts 14 and 15 in NVIC
+    TIMER_A3->CTL = 0x02E4; // SMCLK, divide by 8, continuous mode, reset and start Timer A3
+}
+
+// Queues one rising edge of channel A captured at timer count "capture".
+// "forward" is the level of channel B. An edge that doesn't fit is lost (and counted).
+RAMFUNC static void Edge(struct Wheel *w, uint16_t capture, uint8_t forward)
+{
+    int16_t slot = Ring_Reserve(&w->queue);
+    if (slot >= 0)
+    {
+        w->edges[slot].capture = capture;
+        w->edges[slot].forward = forward;
+        Ring_Publish(&w->queue);
+    }
+}
+
+// Counts the edges the interrupt has queued for one wheel.
+RAMFUNC static void Count(struct Wheel *w)
+{
+    int16_t slot;
+    while ((slot = Ring_Front(&w->queue)) >= 0)
+    {
+        struct Edge e = w->edges[slot];
+        Ring_Pop(&w->queue);
+        if (e.forward)
+        {
+            w->ticks++;
+            w->moved++;
+        }
+        else
+        {
+            w->ticks--;
+            w->moved--;
+        }
+        if (!w->stalled)
+        {
+            w->periodSum += (uint16_t)(e.capture - w->lastCapture);
+            w->timed++;
+        }
+        w->lastCapture = e.capture;
+        w->stalled = 0;
+    }
+}
+
+// Handles a rising edge on the right encoder.
+RAMFUNC void TA3_0_IRQHandler(void)
+{
+    TIMER_A3->CCTL[0] &= ~0x0001; // acknowledge capture 0
+    Edge(&right, TIMER_A3->CCR[0], P5->IN & 0x01);
+}
+
+// Handles a rising edge on the left encoder.
+RAMFUNC void TA3_N_IRQHandler(void)
+{
+    TIMER_A3->CCTL[1] &= ~0x0001; // acknowledge capture 1
+    Edge(&left, TIMER_A3->CCR[1], P5->IN & 0x04);
+}
+
+// Makes both wheels' counted positions what Encoder_Position gives.
+RAMFUNC static void Publish(void)
+{
+    uint32_t sr = StartCritical(); // so an interrupt never sees one wheel updated and not the other
+    left.published = left.ticks;
+    right.published = right.ticks;
+    EndCritical(sr);
+}
+
+// Stores the position of each wheel in ticks (+ forward) since Encoder_Init.
+// Counts the queued edges, so only the main loop may call it.
+void Encoder_Read(int32_t *leftTicks, int32_t *rightTicks)
+{
+    Count(&left);
+    Count(&right);
+    Publish();
+    *leftTicks = left.ticks;
+    *rightTicks = right.ticks;
+}
+
+// Stores the position of each wheel in ticks (+ forward) as of the last Encoder_Read or Encoder_Update.
+// Leaves the edge queues alone, so an interrupt handler can call it.
+void Encoder_Position(int32_t *leftTicks, int32_t *rightTicks)
+{
+    *leftTicks = left.published;
+    *rightTicks = right.published;
+}
+
+// Updates one wheel's speed from the edges since the last update.
+RAMFUNC static void Estimate(struct Wheel *w)
+{
+    Count(w);
+    int16_t edges = w->moved;
+    uint16_t timed = w->timed;
+    uint32_t periodSum = w->periodSum;
+    w->moved = 0;
+    w->timed = 0;
+    w->periodSum = 0;
+
+    if (timed) // average period over the window, which stays accurate at low speed
+    {
+        uint32_t period = periodSum / timed;
+        int16_t speed = SPEED(period ? period : 1);
+        w->speed = (edges < 0) ? -speed : speed;
+        w->idle = 0;
+    }
+    else if (edges) // first edge after a stall; the next one will give a period
+    {
+        w->idle = 0;
+    }
+    else if (++w->idle >= STALL_UPDATES)
+    {
+        w->speed = 0;
+        w->idle = STALL_UPDATES;
+        w->stalled = 1;
+    }
+    else // no edge yet: the wheel can't be going faster than one tick in the time since the last one
+    {
+        int16_t limit = ENCODER_UM_PER_TICK / (w->idle * ENCODER_PERIOD_MS);
+        if (w->speed > limit)
+        {
+            w->speed = limit;
+        }
+        else if (w->speed < -limit)
+        {
+            w->speed = -limit;
+        }
+    }
+}
+
+// Updates the speed estimate of both wheels. Call every ENCODER_PERIOD_MS.
+RAMFUNC void Encoder_Update(void)
+{
+    Estimate(&right);
+    Estimate(&left);
+    Publish();
+}
+
+// Stores the speed of each wheel in mm/s (+ forward), as of the last Encoder_Update.
+RAMFUNC void Encoder_Speed(int16_t *leftSpeed, int16_t *rightSpeed)
+{
+    *leftSpeed = left.speed;
+    *rightSpeed = right.speed;
+}
+
+// Returns the number of edges lost because the main loop didn't count them in time.
+uint16_t Encoder_Overruns(void)
+{
+    return left.queue.overruns + right.queue.overruns;
+}
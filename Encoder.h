@@ -0,0 +1,14 @@
+#define ENCODER_TICKS_PER_REV 360 // rising edges of channel A per wheel turn
+#define ENCODER_UM_PER_TICK 611 // 70mm wheel: 219.9mm per turn / 360
+#define ENCODER_PERIOD_MS 5 // how often Encoder_Update must be called
+#define ENCODER_MM_TO_TICKS(mm) ((int32_t)(mm) * 1000 / ENCODER_UM_PER_TICK)
+#define ENCODER_TICKS_TO_MM(ticks) ((int32_t)(ticks) * ENCODER_UM_PER_TICK / 1000)
+
+void Encoder_Init(void);
+void Encoder_Read(int32_t *left, int32_t *right);
+void Encoder_Position(int32_t *left, int32_t *right);
+void Encoder_Update(void);
+void Encoder_Speed(int16_t *left, int16_t *right);
+uint16_t Encoder_Overruns(void);
+void TA3_0_IRQHandler(void);
+void TA3_N_IRQHandler(void);
@@ -0,0 +1,57 @@
+
+#include "msp.h"
+#include "Flash.h"
+
+// Erases and programs the store sectors through the flash controller, one sector or word at a time.
+// The sectors are write protected except while an operation is running.
+#define FIRST_SECTOR 30 // bank 1 sector of FLASH_STORE_BASE
+
+// Returns the first word of a store sector.
+const uint32_t *Flash_Sector(uint8_t sector)
+{
+    return (const uint32_t *)(FLASH_STORE_BASE + sector * FLASH_SECTOR_SIZE);
+}
+
+// Erases a store sector to all 1s. Takes a few ms. Returns 1 if it reads back erased.
+uint8_t Flash_Erase(uint8_t sector)
+{
+    uint32_t protect = 1ul << (FIRST_SECTOR + sector);
+    const uint32_t *word = Flash_Sector(sector);
+    uint16_t i;
+    FLCTL->BANK1_MAIN_WEPROT &= ~protect; // unprotect the sector
+    FLCTL->ERASE_CTLSTAT &= ~0x0000000E; // sector erase, of main memory
+    FLCTL->ERASE_SECTADDR = (uint32_t)word;
+    FLCTL->CLRIFG = 0x00000020; // clear the erase done flag
+    FLCTL->ERASE_CTLSTAT |= 0x00000001; // start
+    while (!(FLCTL->IFG & 0x00000020)) // wait for the erase to finish
+    {
+    }
+    FLCTL->ERASE_CTLSTAT |= 0x00080000; // clear the erase status
+    FLCTL->BANK1_MAIN_WEPROT |= protect;
+    for (i = 0; i < FLASH_SECTOR_WORDS; i++)
+    {
+        if (word[i] != FLASH_ERASED)
+        {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+// Programs one word of a store sector, which must be erased. Takes about 50us.
+// Returns 1 if it reads back as written.
+uint8_t Flash_Program(uint8_t sector, uint16_t index, uint32_t word)
+{
+    uint32_t protect = 1ul << (FIRST_SECTOR + sector);
+    volatile uint32_t *address = (volatile uint32_t *)&Flash_Sector(sector)[index];
+    FLCTL->BANK1_MAIN_WEPROT &= ~protect;
+    FLCTL->PRG_CTLSTAT = (FLCTL->PRG_CTLSTAT & ~0x00000002) | 0x00000001; // enable immediate (one word) programming
+    FLCTL->CLRIFG = 0x00000008; // clear the program done flag
+    *address = word; // a write to flash starts programming it
+    while (!(FLCTL->IFG & 0x00000008)) // wait for programming to finish
+    {
+    }
+    FLCTL->PRG_CTLSTAT &= ~0x00000001; // back to plain reads
+    FLCTL->BANK1_MAIN_WEPROT |= protect;
+    return *address == word;
+}
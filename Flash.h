@@ -0,0 +1,17 @@
+#ifndef FLASH_H
+#define FLASH_H
+
+// The flash set aside for Store.c: the last two 4KB sectors of main flash (bank 1 sectors 30 and 31),
+// cut out of MAIN in msp432p401r.cmd so no code is linked there. The code runs from bank 0, which can
+// be read while bank 1 is erased or programmed, so nothing has to be copied to RAM first.
+#define FLASH_STORE_BASE 0x0003E000 // must match STORE in msp432p401r.cmd
+#define FLASH_SECTOR_SIZE 4096
+#define FLASH_SECTORS 2
+#define FLASH_SECTOR_WORDS (FLASH_SECTOR_SIZE / 4)
+#define FLASH_ERASED 0xFFFFFFFF // an erased word; programming can only clear bits
+
+const uint32_t *Flash_Sector(uint8_t sector);
+uint8_t Flash_Erase(uint8_t sector);
+uint8_t Flash_Program(uint8_t sector, uint16_t index, uint32_t word);
+
+#endif
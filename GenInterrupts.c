@@ -1,24 +1,36 @@
 
 #include "msp.h"
 #include "GenInterrupts.h"
+#include "RamFunc.h"
 
 // Disable interrupts.
 void DisableInterrupts(void)
 {
-    __asm ("    CPSID  I\n"
-            "    BX     LR\n");
+    __disable_irq();
 }
 
 // Enable interrupts.
 void EnableInterrupts(void)
 {
-    __asm ("    CPSIE  I\n"
-            "    BX     LR\n");
+    __enable_irq();
 }
 
 // Puts the MCU to sleep until an interrupt arrives.
 void WaitForInterrupt(void)
 {
-  __asm  ("    WFI\n"
-          "    BX     LR\n");
+    __WFI();
+}
+
+// Disables interrupts and returns the previous interrupt state (PRIMASK) for EndCritical.
+RAMFUNC uint32_t StartCritical(void)
+{
+    uint32_t sr = __get_PRIMASK();
+    __disable_irq();
+    return sr;
+}
+
+// Restores the interrupt state saved by StartCritical.
+RAMFUNC void EndCritical(uint32_t sr)
+{
+    __set_PRIMASK(sr);
 }
@@ -3,3 +3,5 @@
 void DisableInterrupts(void);
 void EnableInterrupts(void);
 void WaitForInterrupt(void);
+uint32_t StartCritical(void);
+void EndCritical(uint32_t sr);
@@ -1,7 +1,5 @@
 #include "msp.h"
 
-uint8_t lineSensors; // value last read from the line sensors
-
 // State variables
 enum State
 {
@@ -10,7 +8,23 @@ enum State
     WIN, // found the treasure
     SOLUTIONING // showing the solution
 };
-enum State state; // the robot's state
+volatile enum State state; // the robot's state
+
+#define MOVE_SPEED 300 // the standard movement speed of the robot while maze solving, in mm/s
+#define CROSSING_SPEED (MOVE_SPEED * 115 / 100) // 15% faster for driving straight over intersections; integer math so it folds to a constant
+#define SOLUTION_SPEED 450 // the speed for replaying the solution, which has no junctions to find out about, in mm/s
+#define SOLUTION_CROSSING_SPEED (SOLUTION_SPEED * 115 / 100)
+#define CRUISE_ACCEL 1500 // how fast the forward speed ramps, in mm/s^2
+#define CRUISE_JERK 30000 // how fast that acceleration builds up, in mm/s^3
 
-#define MOVE_SPEED 4000// the standard movement speed of the robot while maze solving
+// The speed settings the robot runs with, set from the defines above.
+struct Speeds
+{
+    int16_t move; // exploring, in mm/s
+    int16_t moveCrossing; // driving over junctions while exploring
+    int16_t solution; // replaying the solution
+    int16_t solutionCrossing;
+    int16_t accel; // mm/s^2
+    int16_t jerk; // mm/s^3
+};
 
@@ -0,0 +1,118 @@
+
+#include "msp.h"
+#include "Idle.h"
+#include "GenInterrupts.h"
+#include "MotionProfile.h"
+#include "Motor.h"
+#include "Scheduler.h"
+#include "Telemetry.h"
+#include "Timebase.h"
+#include "TimerWheel.h"
+
+// Main calls Idle_Sleep whenever it has nothing to do, and it picks the deepest mode that stops
+// nothing still in use:
+//   LPM0 (sleep)      the CPU stops; every clock keeps running, so PWM, sensing, the UART and
+//                     SysTick carry on and any interrupt wakes it.
+//   LPM3 (deep sleep) MCLK and SMCLK stop too, which freezes every Timer_A, SysTick, Timer32
+//                     and the UART. Only taken while the scheduler is off (SysTick interrupt
+//                     disabled), no software timer is armed, the motors are off and no telemetry
+//                     is going out. The buttons and bumpers (port interrupts) and the RTC wake it.
+// The timebase (Timer32) stands still in LPM3, so time there is measured on the RTC's prescaler,
+// a 16-bit count of the 32768Hz REFO that wraps every 2 s. The RTC interrupts once a second so no
+// LPM3 sleep lasts long enough for the count to wrap.
+
+static struct IdleStats stats;
+static uint32_t awake; // Timebase_Now when the CPU last woke
+
+// Starts the RTC's prescaler from REFO, to time LPM3, and lets WFI go into LPM3 when SLEEPDEEP is set.
+void Idle_Init(void)
+{
+    CS->KEY = 0x695A; // unlock CS module for register access
+    CS->CTL1 |= 0x00001000; // BCLK from REFOCLK, which keeps running in LPM3 (there's no 32kHz crystal started)
+    CS->KEY = 0; // lock CS module from unintended access
+
+    // PCM_CTL0's LPMR is left at its reset value, so deep sleep is LPM3. Force the entry even though the
+    // Timer_As and the UART ask for SMCLK; only Idle_Sleep decides they can be frozen.
+    PCM->CTL1 = (PCM->CTL1 & ~0xFFFF0000) | 0x695A0000 | 0x00000004; // PCM key, FORCE_LPM_ENTRY
+
+    RTC_C->CTL0 = 0xA500; // unlock the RTC
+    RTC_C->PS1CTL = 0x001A; // RT1PS interrupt every /128 (1 s), enabled
+    RTC_C->CTL13 &= ~0x0040; // clear RTCHOLD: start the calendar and its prescalers
+    RTC_C->CTL0 = 0x0000; // lock the RTC
+    NVIC->IP[29] = 0x60; // priority 3
+    NVIC->ISER[0] = 0x20000000; // enable interrupt 29 in NVIC
+
+    awake = Timebase_Now();
+}
+
+// Returns the RTC prescalers as one 16-bit count of BCLK. They count asynchronously to the CPU, so read until two reads agree.
+static uint16_t RtcCount(void)
+{
+    uint16_t count;
+    do
+    {
+        count = RTC_C->PS;
+    } while (count != RTC_C->PS);
+    return count;
+}
+
+// Returns 1 if nothing running needs MCLK or SMCLK, so LPM3 is safe.
+static uint8_t DeepSleepSafe(void)
+{
+    int16_t left, right;
+    Motor_GetDuty(&left, &right);
+    return !(SysTick->CTRL & 0x2) && !TimerWheel_Active() && !Telemetry_Busy() && (left == 0) && (right == 0);
+}
+
+// Sleeps until an interrupt in the deepest mode that's safe, and adds the time to the statistics.
+// Returns at once if a task was released since main last looked. Call from main instead of WaitForInterrupt.
+void Idle_Sleep(void)
+{
+    uint32_t sr = StartCritical(); // WFI still wakes on an interrupt; its handler runs after EndCritical
+    uint32_t now = Timebase_Now();
+    stats.activeUs += (now - awake) / TIMEBASE_TICKS_PER_US;
+    if (Scheduler_Ready())
+    {
+        awake = now;
+        EndCritical(sr);
+        return;
+    }
+    if (DeepSleepSafe())
+    {
+        uint16_t start = RtcCount();
+        SCB->SCR |= 0x00000004; // SLEEPDEEP: WFI goes into LPM3
+        WaitForInterrupt();
+        SCB->SCR &= ~0x00000004;
+        CS->KEY = 0x695A; // the 48MHz crystal restarts on the way out; wait until it's stable again (as in Clock_Init48MHz)
+        while (CS->IFG & 0x00000002)
+        {
+            CS->CLRIFG = 0x00000002;
+        }
+        CS->KEY = 0;
+        stats.lpm3Us += ((uint32_t)(uint16_t)(RtcCount() - start) * 15625) >> 9; // 1000000 / 32768 = 15625 / 512
+        stats.lpm3Sleeps++;
+        awake = Timebase_Now();
+    }
+    else
+    {
+        WaitForInterrupt(); // LPM0
+        awake = Timebase_Now();
+        stats.lpm0Us += (awake - now) / TIMEBASE_TICKS_PER_US;
+        stats.lpm0Sleeps++;
+    }
+    EndCritical(sr);
+}
+
+// Copies the time spent active and in each low-power mode into "out".
+void Idle_GetStats(struct IdleStats *out)
+{
+    uint32_t sr = StartCritical();
+    *out = stats;
+    EndCritical(sr);
+}
+
+// Handles the RTC's once-a-second interrupt, which is only there to end long LPM3 sleeps.
+void RTC_C_IRQHandler(void)
+{
+    RTC_C->PS1CTL &= ~0x0001; // acknowledge RT1PSIFG
+}
@@ -0,0 +1,19 @@
+#ifndef IDLE_H
+#define IDLE_H
+
+// Where the time has gone since Idle_Init. Each total wraps after 71 minutes.
+struct IdleStats
+{
+    uint32_t activeUs; // running code
+    uint32_t lpm0Us; // asleep with every clock running (WFI)
+    uint32_t lpm3Us; // asleep with only the 32kHz clocks running
+    uint32_t lpm0Sleeps; // number of times it went into LPM0
+    uint32_t lpm3Sleeps; // and into LPM3
+};
+
+void Idle_Init(void);
+void Idle_Sleep(void);
+void Idle_GetStats(struct IdleStats *stats);
+void RTC_C_IRQHandler(void);
+
+#endif
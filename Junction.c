@@ -0,0 +1,219 @@
+
+#include "msp.h"
+#include "LineSensor.h"
+#include "LineTable.h"
+#include "Junction.h"
+#include "Timebase.h"
+#include "RamFunc.h"
+
+// Finds junctions by watching the last few line sensor samples rather than reacting to one.
+// A junction starts when VOTES of the last VOTE_WINDOW samples show black out to a side
+// (APPROACH is reported at once, so the robot can drive straight over it). It is classified once
+// the sensors have been clear of it for CLEAR_SAMPLES in a row: the sides seen on the way over,
+// plus whether the line carries on ahead. Losing the line while it was near the middle is either
+// a gap, if it comes back within GAP_US, or the end of the line. Black right across the sensors for
+// GOAL_US is not a junction at all but the goal square at the end of the maze.
+// Times are the samples' timebase ticks, which wrap at 2^32, so only their differences are used.
+#define HISTORY 8 // samples kept; a power of two
+#define VOTE_WINDOW 3
+#define VOTES 2 // so one odd sample can neither start nor stop a junction
+#define CLEAR_SAMPLES 2
+#define CENTRAL 1500 // the line was lost near the middle if its last position was within this
+#define GAP_US 150000 // longest break in the line that is driven over (45mm at 300mm/s)
+#define GOAL_US 150000 // shortest solid black that is the goal (52mm at crossing speed; a crossing line is ~20mm)
+
+const char *junctionNames[NUM_JUNCTION_TYPES] =
+{
+    "none", "approach", "cross", "T", "left", "right", "end", "gap", "goal"
+};
+
+// What the detector keeps of each sample.
+struct Entry
+{
+    uint32_t time; // timebase ticks
+    int16_t position;
+    uint8_t event; // lineTable event of the sample's pattern
+};
+
+enum Stage
+{
+    FOLLOWING, // on an ordinary line
+    CROSSING, // over a junction, collecting its sides
+    LOST // the line vanished near the middle; waiting to see if it comes back
+};
+
+static struct Entry history[HISTORY]; // ring buffer of recent samples
+static uint8_t newest; // index of the latest sample in history
+static uint8_t count; // number of valid samples in history, up to HISTORY
+static enum Stage stage;
+static uint8_t exits; // EXIT_ bits seen so far in the current junction
+static uint8_t run; // clear (CROSSING) or on-line (LOST) samples in a row
+static uint32_t start; // time (ticks) the current junction or loss started
+static uint32_t solid; // time (ticks) the sensors went all black, while CROSSING
+static uint8_t allBlack; // 1 while every sample since "solid" was all black
+
+// Returns the sample "age" samples before the latest one (0 = latest).
+RAMFUNC static const struct Entry *Recent(uint8_t age)
+{
+    return &history[(newest - age) & (HISTORY - 1)];
+}
+
+// Returns the side exits a pattern event shows.
+RAMFUNC static uint8_t Sides(uint8_t event)
+{
+    if (event == LINE_INTERSECTION)
+    {
+        return EXIT_LEFT | EXIT_RIGHT;
+    }
+    if (event == LINE_LEFT_BRANCH)
+    {
+        return EXIT_LEFT;
+    }
+    if (event == LINE_RIGHT_BRANCH)
+    {
+        return EXIT_RIGHT;
+    }
+    return 0;
+}
+
+// Fills in "event" and returns 1, so Junction_Add can report in one line.
+RAMFUNC static uint8_t Report(struct JunctionEvent *event, uint8_t type, uint32_t time)
+{
+    event->type = type;
+    event->exits = (type == JUNCTION_APPROACH) ? 0 : exits;
+    event->start = start;
+    event->time = time;
+    return 1;
+}
+
+// Forgets all samples. Call after anything that moves the robot off the line it was following, like a turn.
+void Junction_Reset(void)
+{
+    count = 0;
+    stage = FOLLOWING;
+}
+
+// Adds the next line sensor sample. Call once per new sample.
+// Returns 1 and fills in "event" when something happened, otherwise returns 0.
+RAMFUNC uint8_t Junction_Add(const struct LineSensorSample *sample, struct JunctionEvent *event)
+{
+    newest = (newest + 1) & (HISTORY - 1);
+    struct Entry *e = &history[newest];
+    e->time = sample->time;
+    e->position = sample->position;
+    e->event = lineTable[sample->bits].event;
+    if (count < HISTORY)
+    {
+        count++;
+    }
+
+    if (stage == FOLLOWING)
+    {
+        uint8_t votes = 0, lostVotes = 0, sides = 0, age;
+        uint32_t first = e->time, firstLost = e->time;
+        for (age = 0; (age < VOTE_WINDOW) && (age < count); age++)
+        {
+            const struct Entry *r = Recent(age);
+            if (Sides(r->event))
+            {
+                votes++;
+                sides |= Sides(r->event);
+                first = r->time;
+            }
+            if (r->event == LINE_LOST)
+            {
+                lostVotes++;
+                firstLost = r->time;
+            }
+        }
+        if (votes >= VOTES)
+        {
+            stage = CROSSING;
+            exits = sides;
+            run = 0;
+            start = first;
+            allBlack = 0;
+            return Report(event, JUNCTION_APPROACH, e->time);
+        }
+        if (lostVotes >= VOTES)
+        {
+            for (; age < count; age++) // find where the line was last seen
+            {
+                const struct Entry *r = Recent(age);
+                if (r->event != LINE_LOST)
+                {
+                    if ((r->position >= -CENTRAL) && (r->position <= CENTRAL)) // not just drifting off a curve
+                    {
+                        stage = LOST;
+                        exits = 0;
+                        run = 0;
+                        start = firstLost;
+                        return Report(event, JUNCTION_APPROACH, e->time);
+                    }
+                    break;
+                }
+            }
+        }
+        return 0;
+    }
+
+    if (stage == CROSSING)
+    {
+        if (e->event != LINE_INTERSECTION)
+        {
+            allBlack = 0;
+        }
+        else if (!allBlack)
+        {
+            allBlack = 1;
+            solid = e->time;
+        }
+        else if (e->time - solid >= GOAL_US * TIMEBASE_TICKS_PER_US)
+        {
+            stage = FOLLOWING;
+            exits = 0;
+            return Report(event, JUNCTION_GOAL, e->time);
+        }
+        if (Sides(e->event))
+        {
+            exits |= Sides(e->event);
+            run = 0;
+            return 0;
+        }
+        if (++run < CLEAR_SAMPLES)
+        {
+            return 0;
+        }
+        // Past the junction: the line goes on ahead if the clear samples still see it.
+        if ((e->event != LINE_LOST) && (Recent(1)->event != LINE_LOST))
+        {
+            exits |= EXIT_STRAIGHT;
+        }
+        stage = FOLLOWING;
+        if ((exits & (EXIT_LEFT | EXIT_RIGHT)) == (EXIT_LEFT | EXIT_RIGHT))
+        {
+            return Report(event, (exits & EXIT_STRAIGHT) ? JUNCTION_CROSS : JUNCTION_T, e->time);
+        }
+        return Report(event, (exits & EXIT_LEFT) ? JUNCTION_LEFT : JUNCTION_RIGHT, e->time);
+    }
+
+    // LOST
+    if (e->event != LINE_LOST)
+    {
+        if (++run >= CLEAR_SAMPLES)
+        {
+            stage = FOLLOWING;
+            exits = EXIT_STRAIGHT;
+            return Report(event, JUNCTION_GAP, e->time);
+        }
+        return 0;
+    }
+    run = 0;
+    if (e->time - start >= GAP_US * TIMEBASE_TICKS_PER_US)
+    {
+        stage = FOLLOWING;
+        exits = 0;
+        return Report(event, JUNCTION_END, e->time);
+    }
+    return 0;
+}
@@ -0,0 +1,37 @@
+#ifndef JUNCTION_H
+#define JUNCTION_H
+
+// What the junction detector found.
+enum JunctionType
+{
+    JUNCTION_NONE, // nothing yet
+    JUNCTION_APPROACH, // something is under the sensors; drive straight until it is classified
+    JUNCTION_CROSS, // 4-way intersection
+    JUNCTION_T, // T: left and right, nothing ahead
+    JUNCTION_LEFT, // branch to the left (the exits say whether the line also goes on ahead)
+    JUNCTION_RIGHT, // branch to the right (likewise)
+    JUNCTION_END, // the line ends
+    JUNCTION_GAP, // a short break in the line, which carries on ahead
+    JUNCTION_GOAL, // a solid black square: the end of the maze
+    NUM_JUNCTION_TYPES
+};
+
+// Ways out of a junction, for JunctionEvent.exits.
+#define EXIT_LEFT 0x01
+#define EXIT_STRAIGHT 0x02
+#define EXIT_RIGHT 0x04
+
+struct JunctionEvent
+{
+    uint8_t type; // enum JunctionType
+    uint8_t exits; // EXIT_ bits; 0 for JUNCTION_APPROACH, JUNCTION_END and JUNCTION_GOAL
+    uint32_t start; // time of the first sample that showed the junction, in timebase ticks
+    uint32_t time; // time of the sample that decided it, in timebase ticks
+};
+
+extern const char *junctionNames[NUM_JUNCTION_TYPES];
+
+void Junction_Reset(void);
+uint8_t Junction_Add(const struct LineSensorSample *sample, struct JunctionEvent *event);
+
+#endif
@@ -1,8 +1,64 @@
+
 #include "msp.h"
 #include "LineSensor.h"
-#include "Clock.h"
+#include "Dma.h"
+#include "RamFunc.h"
+#include "Ring.h"
+#include "Timebase.h"
+#include "Probe.h"
+
+// Timer A2 runs from SMCLK (12MHz), so 12 counts = 1us.
+// P7 has no port interrupts, and only half its pins reach a timer capture input (Timer A1's, which
+// runs the software timers), so the discharge can't be timed edge by edge. Instead DMA channel 4
+// copies P7->IN into levels[] every STEP_US, triggered by Timer A2's CCR0 with no interrupt, and the
+// channel finishing raises DMA_INT2 once the whole MAX_US has been sampled. A read takes two
+// interrupts: one when the capacitors are charged and one at the end.
+#define CHARGE_TIME (10 * 12) // 10us to charge the capacitors
+#define STEP_US 25 // time between samples of P7 while the capacitors discharge
+#define STEP_TIME (STEP_US * 12)
+#define MAX_US 2500 // stop timing a channel after this long; it reads as fully black
+#define STEPS (MAX_US / STEP_US) // samples of P7 in a read
+
+// Each channel is scaled from its own white and black times to a value from 0 to 1000, so channels
+// that read darker or lighter than the rest (or the whole bar, on a shinier surface) agree on what
+// black is. The calibration comes from LineSensor_CalibrateStart/End sweeping the bar over the line,
+// and then follows slow drifts during runs: channels that read clearly white or clearly black pull
+// their white or black time toward what they read, by 1/ADAPT_RATE of the difference per sample.
+#define DEFAULT_WHITE_US 200 // calibration before any is done: halfway between these is 800us,
+#define DEFAULT_BLACK_US 1400 // the fixed threshold this replaced
+#define THRESHOLD 500 // values above this are black
+#define FLOOR 170 // values at or below this count as plain white when finding the line position (400us by default)
+#define CLEAR_WHITE 250 // samples must be this clearly white or black to adapt the calibration
+#define CLEAR_BLACK 750
+#define ADAPT_SHIFT 10 // adapt by 1/1024 per sample: a time constant of about 5s at 200 samples/s
+#define MIN_CONTRAST 300 // us between white and black, below which a channel's calibration is not believed
+
+// Steps of an interrupt-driven read.
+enum LineSensorStage
+{
+    IDLE, // no read in progress
+    CHARGING, // IR LED on and P7 driven high
+    DISCHARGING // P7 released, and the DMA sampling it
+};
+static volatile enum LineSensorStage stage = IDLE; // the current step of the read in progress
+
+#define QUEUE 4 // samples that can wait for the main loop; a power of two
+
+static struct LineSensorSample samples[QUEUE]; // the ISR fills these and main takes them in order
+static struct Ring queue = RING_INIT(QUEUE);
+static struct LineSensorSample dropped; // where a sample goes when the queue is full
+static struct LineSensorSample latest; // the last sample main took
+static volatile uint32_t sequence; // number of samples read so far
+static struct LineSensorSample *volatile newest; // the sample the ISR wrote last, for LineSensor_Latest
+static uint8_t levels[STEPS]; // P7->IN every STEP_US after it was released, written by the DMA
+static uint16_t times[8]; // discharge time of each channel for the read in progress
+static int16_t lastPosition; // the position last published while the line was in view
+static uint32_t white[8], black[8]; // each channel's calibration, in us << ADAPT_SHIFT
+static uint16_t low[8], high[8]; // shortest and longest times seen while calibrating
+static volatile uint8_t calibrating; // 1 between LineSensor_CalibrateStart and LineSensor_CalibrateEnd
 
-// Initializes the line sensor bar.
+// Initializes the line sensor bar, Timer A2, which times the charge and discharge, and DMA channel 4,
+// which samples the discharge.
 void LineSensor_Init()
 {
     // P5.3 is the IR LED
@@ -16,21 +72,305 @@ void LineSensor_Init()
     P7->SEL1 = 0; // set all P7 pins to GPIO
     P7->DIR = 0; // set all P7 pins to input
     P7->REN = 0; // disable pull resistors on P7 pins
+
+    int i;
+    for (i = 0; i < 8; i++)
+    {
+        white[i] = (uint32_t)DEFAULT_WHITE_US << ADAPT_SHIFT;
+        black[i] = (uint32_t)DEFAULT_BLACK_US << ADAPT_SHIFT;
+    }
+
+    TIMER_A2->CTL &= ~0x0030; // stop Timer A2
+    TIMER_A2->CTL = 0x0200; // SMCLK, divider /1, stopped
+    TIMER_A2->EX0 = 0; // no extra clock divider
+    TIMER_A2->CCTL[0] = 0x0010; // compare, interrupt on CCR0
+    NVIC->IP[12] = 0x20; // priority 1, above SysTick so the latch isn't delayed
+    NVIC->ISER[0] = 0x00001000; // enable interrupt 12 in NVIC
+
+    Dma_Init();
+    DMA_Control->ALTCLR = 0x10; // channel 4 uses its primary structure,
+    DMA_Control->PRIOCLR = 0x10; // at default priority,
+    DMA_Control->USEBURSTCLR = 0x10; // for single requests too,
+    DMA_Control->REQMASKCLR = 0x10; // which aren't masked
+    DMA_Channel->CH_SRCCFG[4] = 6; // channel 4 is triggered by Timer A2 CCR0
+    DMA_Channel->INT2_SRCCFG = 0x24; // channel 4 finishing raises DMA_INT2
+    NVIC->IP[32] = 0x20; // priority 1, the same as Timer A2's
+    NVIC->ISER[1] = 0x00000001; // enable interrupt 32 (DMA_INT2) in NVIC
 }
 
-// Read the line sensors and returns the value as an 8-bit unsigned int.
-// 0 = white, 1 = black.
-// Bit 0 = right-most sensor.
-// Bit 7 = left-most sensor.
-uint8_t LineSensor_Read()
+// Starts reading the line sensors and returns immediately.
+// The result is published by DMA_INT2_IRQHandler once the discharge has been sampled for MAX_US (2.5ms).
+// Returns 0 if a read was already in progress, 1 otherwise.
+uint8_t LineSensor_Start()
 {
+    if (stage != IDLE) // only one read at a time
+    {
+        return 0;
+    }
+    stage = CHARGING;
     P5->OUT |= 0x08; // set P5.3 high (turn on LED)
     P7->DIR = 0xFF; // set P7 as output
     P7->OUT = 0xFF; // set P7 pins high
-    Clock_Delay1us(10); // delay 10us to charge the capacitors
+    TIMER_A2->CCTL[0] = 0x0010; // compare, interrupt on CCR0, flag clear
+    TIMER_A2->CCR[0] = CHARGE_TIME - 1; // interrupt when the capacitors are charged
+    TIMER_A2->CTL |= 0x0014; // reset and start Timer A2 in up mode
+    return 1;
+}
+
+// Finds the line position from the calibrated values, from -3500 (under the left-most sensor)
+// to +3500 (under the right-most sensor), interpolating between sensors.
+// Returns 1 if any sensor sees the line. Otherwise leaves position at the side the line was last seen on and returns 0.
+RAMFUNC uint8_t LineSensor_Position(const uint16_t values[8], int16_t *position)
+{
+    int32_t sum = 0; // sum of all weights
+    int32_t weighted = 0; // sum of weight * sensor position
+    int i;
+    for (i = 0; i < 8; i++)
+    {
+        if (values[i] > FLOOR) // only count channels darker than plain white
+        {
+            int32_t weight = values[i] - FLOOR;
+            sum += weight;
+            weighted += weight * (3500 - 1000 * i); // bit 0 is right-most (+3500), bit 7 is left-most (-3500)
+        }
+    }
+    if (sum == 0) // nothing is darker than white, so the line is lost
+    {
+        *position = (lastPosition < 0) ? -3500 : 3500; // assume it's off the side it was last seen on
+        return 0;
+    }
+    *position = weighted / sum;
+    return 1;
+}
+
+// Scales channel i's discharge time to 0 (white) to 1000 (black) and lets the calibration follow it.
+RAMFUNC static uint16_t Normalize(int i, uint16_t time)
+{
+    uint16_t w = white[i] >> ADAPT_SHIFT, b = black[i] >> ADAPT_SHIFT;
+    if (calibrating)
+    {
+        if (time < low[i])
+        {
+            low[i] = time;
+        }
+        if (time > high[i])
+        {
+            high[i] = time;
+        }
+    }
+    uint16_t value = 0;
+    if (time >= b)
+    {
+        value = 1000;
+    }
+    else if (time > w)
+    {
+        value = (uint32_t)(time - w) * 1000 / (b - w);
+    }
+    if ((value < CLEAR_WHITE) && (time + MIN_CONTRAST < b))
+    {
+        white[i] += time - w; // white += (time - w) / 1024, in the scaled units
+    }
+    else if ((value > CLEAR_BLACK) && (time > w + MIN_CONTRAST))
+    {
+        black[i] += time - b;
+    }
+    return value;
+}
+
+// Handles Timer A2 interrupting once the capacitors are charged: releases P7 and starts the DMA sampling it.
+RAMFUNC void TA2_0_IRQHandler()
+{
+    PROBE_BEGIN(PROBE_SENSOR_ISR);
+    TIMER_A2->CTL &= ~0x0030; // stop Timer A2
+    TIMER_A2->CCTL[0] = 0x0000; // compare, no interrupt: from here CCR0 only triggers the DMA
     P7->DIR = 0; // set P7 as input
-    Clock_Delay1us(800); // delay 0.8ms to discharge the capacitors slightly
-    uint8_t result = P7->IN; // read P7
-    P5->OUT &= ~0x08; // set P5.3 low (turn off LED)
-    return result;
+    dmaTable[4].srcEnd = &P7->IN;
+    dmaTable[4].dstEnd = &levels[STEPS - 1];
+    dmaTable[4].control = 0x0C000000 // destination steps a byte at a time, source doesn't increment,
+            | ((uint32_t)(STEPS - 1) << 4) // one byte per request,
+            | 0x1; // basic mode
+    DMA_Control->ENASET = 0x10; // enable channel 4
+    TIMER_A2->CCR[0] = STEP_TIME - 1; // a sample every STEP_US while the capacitors discharge
+    TIMER_A2->CTL |= 0x0014; // reset and start Timer A2 in up mode
+    stage = DISCHARGING;
+    PROBE_END(PROBE_SENSOR_ISR);
+}
+
+// Handles the DMA having sampled the whole discharge: finds each channel's discharge time and publishes the sample.
+RAMFUNC void DMA_INT2_IRQHandler()
+{
+    PROBE_BEGIN(PROBE_SENSOR_ISR);
+    DMA_Channel->INT0_CLRFLG = 0x10; // acknowledge channel 4
+    if (stage == DISCHARGING)
+    {
+        P5->OUT &= ~0x08; // set P5.3 low (turn off LED)
+        TIMER_A2->CTL &= ~0x0030; // stop Timer A2
+
+        uint8_t charged = 0xFF; // channels that haven't discharged yet
+        int i, k;
+        for (k = 0; (k < STEPS) && charged; k++)
+        {
+            uint8_t fell = charged & ~levels[k]; // channels that discharged since the last sample
+            charged &= ~fell;
+            for (i = 0; fell; i++, fell >>= 1)
+            {
+                if (fell & 0x01)
+                {
+                    times[i] = (k + 1) * STEP_US;
+                }
+            }
+        }
+        for (i = 0; i < 8; i++) // channels that never discharged get the maximum time
+        {
+            if (charged & (1 << i))
+            {
+                times[i] = MAX_US;
+            }
+        }
+
+        int16_t slot = calibrating ? -1 : Ring_Reserve(&queue); // -1 if main has fallen QUEUE samples behind (or isn't listening)
+        struct LineSensorSample *next = (slot >= 0) ? &samples[slot] : &dropped;
+        next->bits = 0;
+        for (i = 0; i < 8; i++)
+        {
+            next->times[i] = times[i];
+            next->values[i] = Normalize(i, times[i]);
+            if (next->values[i] > THRESHOLD)
+            {
+                next->bits |= 1 << i;
+            }
+        }
+        next->onLine = LineSensor_Position(next->values, &next->position);
+        if (next->onLine)
+        {
+            lastPosition = next->position;
+        }
+        next->time = Timebase_Now();
+        next->sequence = sequence + 1;
+        newest = next;
+        sequence = next->sequence; // last, so LineSensor_Latest can tell if it was interrupted
+        if (slot >= 0)
+        {
+            Ring_Publish(&queue);
+        }
+        stage = IDLE;
+    }
+    PROBE_END(PROBE_SENSOR_ISR);
+}
+
+// Takes the oldest sample main hasn't had yet, if there is one, into "sample" and returns 1.
+// Returns 0 if every sample has been taken. Samples come in the order they were read.
+// Sample bits: 0 = white, 1 = black.
+// Bit 0 = right-most sensor.
+// Bit 7 = left-most sensor.
+RAMFUNC uint8_t LineSensor_Next(struct LineSensorSample *sample)
+{
+    int16_t slot = Ring_Front(&queue);
+    if (slot < 0)
+    {
+        return 0;
+    }
+    latest = samples[slot];
+    Ring_Pop(&queue);
+    *sample = latest;
+    return 1;
+}
+
+// Takes every waiting sample and copies the newest (or, if none were waiting, the last one taken)
+// into "sample". Returns its sequence number, which increases by one for each read, so a gap shows
+// samples dropped because main fell behind.
+uint32_t LineSensor_GetSample(struct LineSensorSample *sample)
+{
+    while (LineSensor_Next(sample))
+    {
+    }
+    *sample = latest;
+    return sample->sequence;
+}
+
+// Copies the newest sample read, whether or not main has taken it, into "sample" and returns its sequence
+// number (0 if nothing has been read yet). Leaves the queue alone, so an interrupt handler can watch the
+// line while main takes every sample in order. Safe at any priority below the sensor's.
+uint32_t LineSensor_Latest(struct LineSensorSample *sample)
+{
+    uint32_t before;
+    do // if the sensor interrupt wrote a new sample part way through the copy, copy that one instead
+    {
+        before = sequence;
+        if (before == 0)
+        {
+            return 0;
+        }
+        *sample = *newest;
+    } while (sequence != before);
+    return before;
+}
+
+// Returns the number of samples dropped because main didn't take them in time.
+uint16_t LineSensor_Overruns(void)
+{
+    return queue.overruns;
+}
+
+// Starts recording the shortest and longest time of each channel. Sweep the sensors over the line
+// (and keep reads going) until LineSensor_CalibrateEnd.
+void LineSensor_CalibrateStart(void)
+{
+    int i;
+    for (i = 0; i < 8; i++)
+    {
+        low[i] = MAX_US;
+        high[i] = 0;
+    }
+    calibrating = 1;
+}
+
+// Stops recording and calibrates each channel to the times it saw, if the line and the white on
+// either side of it both passed under it. A channel that didn't see both keeps its old calibration.
+// Returns 1 if every channel was calibrated.
+uint8_t LineSensor_CalibrateEnd(void)
+{
+    uint8_t all = 1;
+    int i;
+    calibrating = 0;
+    for (i = 0; i < 8; i++)
+    {
+        if (high[i] >= low[i] + MIN_CONTRAST)
+        {
+            white[i] = (uint32_t)low[i] << ADAPT_SHIFT;
+            black[i] = (uint32_t)high[i] << ADAPT_SHIFT;
+        }
+        else
+        {
+            all = 0;
+        }
+    }
+    return all;
+}
+
+// Copies the current calibration, as it has adapted, into "calibration".
+void LineSensor_GetCalibration(struct LineSensorCalibration *calibration)
+{
+    int i;
+    for (i = 0; i < 8; i++)
+    {
+        calibration->white[i] = white[i] >> ADAPT_SHIFT;
+        calibration->black[i] = black[i] >> ADAPT_SHIFT;
+    }
+}
+
+// Replaces the calibration, for example with one kept in the store. Channels whose white and black
+// are too close together to be real are left alone.
+void LineSensor_SetCalibration(const struct LineSensorCalibration *calibration)
+{
+    int i;
+    for (i = 0; i < 8; i++)
+    {
+        if (calibration->black[i] >= calibration->white[i] + MIN_CONTRAST)
+        {
+            white[i] = (uint32_t)calibration->white[i] << ADAPT_SHIFT;
+            black[i] = (uint32_t)calibration->black[i] << ADAPT_SHIFT;
+        }
+    }
 }
@@ -1,3 +1,37 @@
+#ifndef LINESENSOR_H
+#define LINESENSOR_H
+
+// One complete read of the line sensors.
+struct LineSensorSample
+{
+    uint8_t bits; // 0 = white, 1 = black; bit 0 = right-most sensor, bit 7 = left-most sensor
+    uint16_t times[8]; // discharge time of each channel in us, indexed by bit number; longer = darker
+    uint16_t values[8]; // the times scaled by the channel's calibration, from 0 (white) to 1000 (black)
+    int16_t position; // line position from -3500 (left-most sensor) to +3500 (right-most sensor)
+    uint8_t onLine; // 1 if any sensor saw the line; otherwise position is pinned to the side it was last seen on
+    uint32_t sequence; // increases by one for each read
+    uint32_t time; // Timebase_Now() when the read finished, in timebase ticks; subtract two to get an interval
+};
+
+// What each channel reads over white and over the middle of the line, in us of discharge time.
+struct LineSensorCalibration
+{
+    uint16_t white[8];
+    uint16_t black[8];
+};
 
 void LineSensor_Init();
-uint8_t LineSensor_Read();
+uint8_t LineSensor_Start();
+void TA2_0_IRQHandler();
+void DMA_INT2_IRQHandler();
+uint8_t LineSensor_Position(const uint16_t values[8], int16_t *position);
+uint8_t LineSensor_Next(struct LineSensorSample *sample);
+uint32_t LineSensor_GetSample(struct LineSensorSample *sample);
+uint32_t LineSensor_Latest(struct LineSensorSample *sample);
+uint16_t LineSensor_Overruns(void);
+void LineSensor_CalibrateStart(void);
+uint8_t LineSensor_CalibrateEnd(void);
+void LineSensor_GetCalibration(struct LineSensorCalibration *calibration);
+void LineSensor_SetCalibration(const struct LineSensorCalibration *calibration);
+
+#endif
@@ -0,0 +1,267 @@
+/* LineTable.c
+ * Generated by Tools/GenLineTable from Tools/LineRules.txt. Don't edit this
+ * file; change the rules and regenerate it (see Tools/GenLineTable.c).
+ */
+
+#include "msp.h"
+#include "LineTable.h"
+
+const struct LineClass lineTable[256] =
+{
+    { LINE_HOLD, LINE_LOST, 0 }, // 00 00000000
+    { 3500, LINE_FOLLOW, 100 }, // 01 00000001
+    { 2500, LINE_FOLLOW, 100 }, // 02 00000010
+    { 3000, LINE_FOLLOW, 100 }, // 03 00000011
+    { 1500, LINE_FOLLOW, 100 }, // 04 00000100
+    { 1500, LINE_FOLLOW, 40 }, // 05 00000101
+    { 2000, LINE_FOLLOW, 100 }, // 06 00000110
+    { 2500, LINE_FOLLOW, 100 }, // 07 00000111
+    { 500, LINE_FOLLOW, 100 }, // 08 00001000
+    { 500, LINE_FOLLOW, 40 }, // 09 00001001
+    { 500, LINE_FOLLOW, 40 }, // 0A 00001010
+    { 3000, LINE_FOLLOW, 40 }, // 0B 00001011
+    { 1000, LINE_FOLLOW, 100 }, // 0C 00001100
+    { 1000, LINE_FOLLOW, 40 }, // 0D 00001101
+    { 1500, LINE_FOLLOW, 100 }, // 0E 00001110
+    { 2000, LINE_FOLLOW, 100 }, // 0F 00001111
+    { -500, LINE_FOLLOW, 100 }, // 10 00010000
+    { -500, LINE_FOLLOW, 40 }, // 11 00010001
+    { -500, LINE_FOLLOW, 40 }, // 12 00010010
+    { 3000, LINE_FOLLOW, 40 }, // 13 00010011
+    { -500, LINE_FOLLOW, 40 }, // 14 00010100
+    { -500, LINE_FOLLOW, 40 }, // 15 00010101
+    { 2000, LINE_FOLLOW, 40 }, // 16 00010110
+    { 2500, LINE_FOLLOW, 40 }, // 17 00010111
+    { 0, LINE_FOLLOW, 100 }, // 18 00011000
+    { 0, LINE_FOLLOW, 40 }, // 19 00011001
+    { 0, LINE_FOLLOW, 40 }, // 1A 00011010
+    { 0, LINE_FOLLOW, 40 }, // 1B 00011011
+    { 500, LINE_FOLLOW, 100 }, // 1C 00011100
+    { 500, LINE_FOLLOW, 40 }, // 1D 00011101
+    { 1000, LINE_RIGHT_BRANCH, 60 }, // 1E 00011110
+    { 1500, LINE_RIGHT_BRANCH, 60 }, // 1F 00011111
+    { -1500, LINE_FOLLOW, 100 }, // 20 00100000
+    { -1500, LINE_FOLLOW, 40 }, // 21 00100001
+    { -1500, LINE_FOLLOW, 40 }, // 22 00100010
+    { 3000, LINE_FOLLOW, 40 }, // 23 00100011
+    { -1500, LINE_FOLLOW, 40 }, // 24 00100100
+    { -1500, LINE_FOLLOW, 40 }, // 25 00100101
+    { 2000, LINE_FOLLOW, 40 }, // 26 00100110
+    { 2500, LINE_FOLLOW, 40 }, // 27 00100111
+    { -1500, LINE_FOLLOW, 40 }, // 28 00101000
+    { -1500, LINE_FOLLOW, 40 }, // 29 00101001
+    { -1500, LINE_FOLLOW, 40 }, // 2A 00101010
+    { 3000, LINE_FOLLOW, 40 }, // 2B 00101011
+    { 1000, LINE_FOLLOW, 40 }, // 2C 00101100
+    { 1000, LINE_FOLLOW, 40 }, // 2D 00101101
+    { 1500, LINE_FOLLOW, 40 }, // 2E 00101110
+    { 2000, LINE_FOLLOW, 40 }, // 2F 00101111
+    { -1000, LINE_FOLLOW, 100 }, // 30 00110000
+    { -1000, LINE_FOLLOW, 40 }, // 31 00110001
+    { -1000, LINE_FOLLOW, 40 }, // 32 00110010
+    { -1000, LINE_FOLLOW, 40 }, // 33 00110011
+    { -1000, LINE_FOLLOW, 40 }, // 34 00110100
+    { -1000, LINE_FOLLOW, 40 }, // 35 00110101
+    { -1000, LINE_FOLLOW, 40 }, // 36 00110110
+    { 2500, LINE_FOLLOW, 40 }, // 37 00110111
+    { -500, LINE_FOLLOW, 100 }, // 38 00111000
+    { -500, LINE_FOLLOW, 40 }, // 39 00111001
+    { -500, LINE_FOLLOW, 40 }, // 3A 00111010
+    { -500, LINE_FOLLOW, 40 }, // 3B 00111011
+    { 0, LINE_FOLLOW, 100 }, // 3C 00111100
+    { 0, LINE_FOLLOW, 40 }, // 3D 00111101
+    { 500, LINE_FOLLOW, 100 }, // 3E 00111110
+    { 1000, LINE_RIGHT_BRANCH, 70 }, // 3F 00111111
+    { -2500, LINE_FOLLOW, 100 }, // 40 01000000
+    { -2500, LINE_FOLLOW, 40 }, // 41 01000001
+    { -2500, LINE_FOLLOW, 40 }, // 42 01000010
+    { 3000, LINE_FOLLOW, 40 }, // 43 01000011
+    { -2500, LINE_FOLLOW, 40 }, // 44 01000100
+    { -2500, LINE_FOLLOW, 40 }, // 45 01000101
+    { 2000, LINE_FOLLOW, 40 }, // 46 01000110
+    { 2500, LINE_FOLLOW, 40 }, // 47 01000111
+    { -2500, LINE_FOLLOW, 40 }, // 48 01001000
+    { -2500, LINE_FOLLOW, 40 }, // 49 01001001
+    { -2500, LINE_FOLLOW, 40 }, // 4A 01001010
+    { 3000, LINE_FOLLOW, 40 }, // 4B 01001011
+    { 1000, LINE_FOLLOW, 40 }, // 4C 01001100
+    { 1000, LINE_FOLLOW, 40 }, // 4D 01001101
+    { 1500, LINE_FOLLOW, 40 }, // 4E 01001110
+    { 2000, LINE_FOLLOW, 40 }, // 4F 01001111
+    { -2500, LINE_FOLLOW, 40 }, // 50 01010000
+    { -2500, LINE_FOLLOW, 40 }, // 51 01010001
+    { -2500, LINE_FOLLOW, 40 }, // 52 01010010
+    { 3000, LINE_FOLLOW, 40 }, // 53 01010011
+    { -2500, LINE_FOLLOW, 40 }, // 54 01010100
+    { -2500, LINE_FOLLOW, 40 }, // 55 01010101
+    { 2000, LINE_FOLLOW, 40 }, // 56 01010110
+    { 2500, LINE_FOLLOW, 40 }, // 57 01010111
+    { 0, LINE_FOLLOW, 40 }, // 58 01011000
+    { 0, LINE_FOLLOW, 40 }, // 59 01011001
+    { 0, LINE_FOLLOW, 40 }, // 5A 01011010
+    { 0, LINE_FOLLOW, 40 }, // 5B 01011011
+    { 500, LINE_FOLLOW, 40 }, // 5C 01011100
+    { 500, LINE_FOLLOW, 40 }, // 5D 01011101
+    { 1000, LINE_FOLLOW, 40 }, // 5E 01011110
+    { 1500, LINE_FOLLOW, 40 }, // 5F 01011111
+    { -2000, LINE_FOLLOW, 100 }, // 60 01100000
+    { -2000, LINE_FOLLOW, 40 }, // 61 01100001
+    { -2000, LINE_FOLLOW, 40 }, // 62 01100010
+    { -2000, LINE_FOLLOW, 40 }, // 63 01100011
+    { -2000, LINE_FOLLOW, 40 }, // 64 01100100
+    { -2000, LINE_FOLLOW, 40 }, // 65 01100101
+    { -2000, LINE_FOLLOW, 40 }, // 66 01100110
+    { 2500, LINE_FOLLOW, 40 }, // 67 01100111
+    { -2000, LINE_FOLLOW, 40 }, // 68 01101000
+    { -2000, LINE_FOLLOW, 40 }, // 69 01101001
+    { -2000, LINE_FOLLOW, 40 }, // 6A 01101010
+    { -2000, LINE_FOLLOW, 40 }, // 6B 01101011
+    { -2000, LINE_FOLLOW, 40 }, // 6C 01101100
+    { -2000, LINE_FOLLOW, 40 }, // 6D 01101101
+    { 1500, LINE_FOLLOW, 40 }, // 6E 01101110
+    { 2000, LINE_FOLLOW, 40 }, // 6F 01101111
+    { -1500, LINE_FOLLOW, 100 }, // 70 01110000
+    { -1500, LINE_FOLLOW, 40 }, // 71 01110001
+    { -1500, LINE_FOLLOW, 40 }, // 72 01110010
+    { -1500, LINE_FOLLOW, 40 }, // 73 01110011
+    { -1500, LINE_FOLLOW, 40 }, // 74 01110100
+    { -1500, LINE_FOLLOW, 40 }, // 75 01110101
+    { -1500, LINE_FOLLOW, 40 }, // 76 01110110
+    { -1500, LINE_FOLLOW, 40 }, // 77 01110111
+    { -1000, LINE_FOLLOW, 100 }, // 78 01111000
+    { -1000, LINE_FOLLOW, 40 }, // 79 01111001
+    { -1000, LINE_FOLLOW, 40 }, // 7A 01111010
+    { -1000, LINE_FOLLOW, 40 }, // 7B 01111011
+    { -500, LINE_FOLLOW, 100 }, // 7C 01111100
+    { -500, LINE_FOLLOW, 40 }, // 7D 01111101
+    { 0, LINE_FOLLOW, 100 }, // 7E 01111110
+    { 500, LINE_INTERSECTION, 90 }, // 7F 01111111
+    { -3500, LINE_FOLLOW, 100 }, // 80 10000000
+    { -3500, LINE_FOLLOW, 40 }, // 81 10000001
+    { -3500, LINE_FOLLOW, 40 }, // 82 10000010
+    { 3000, LINE_FOLLOW, 40 }, // 83 10000011
+    { -3500, LINE_FOLLOW, 40 }, // 84 10000100
+    { -3500, LINE_FOLLOW, 40 }, // 85 10000101
+    { 2000, LINE_FOLLOW, 40 }, // 86 10000110
+    { 2500, LINE_FOLLOW, 40 }, // 87 10000111
+    { -3500, LINE_FOLLOW, 40 }, // 88 10001000
+    { -3500, LINE_FOLLOW, 40 }, // 89 10001001
+    { -3500, LINE_FOLLOW, 40 }, // 8A 10001010
+    { 3000, LINE_FOLLOW, 40 }, // 8B 10001011
+    { 1000, LINE_FOLLOW, 40 }, // 8C 10001100
+    { 1000, LINE_FOLLOW, 40 }, // 8D 10001101
+    { 1500, LINE_FOLLOW, 40 }, // 8E 10001110
+    { 2000, LINE_FOLLOW, 40 }, // 8F 10001111
+    { -3500, LINE_FOLLOW, 40 }, // 90 10010000
+    { -3500, LINE_FOLLOW, 40 }, // 91 10010001
+    { -3500, LINE_FOLLOW, 40 }, // 92 10010010
+    { 3000, LINE_FOLLOW, 40 }, // 93 10010011
+    { -3500, LINE_FOLLOW, 40 }, // 94 10010100
+    { -3500, LINE_FOLLOW, 40 }, // 95 10010101
+    { 2000, LINE_FOLLOW, 40 }, // 96 10010110
+    { 2500, LINE_FOLLOW, 40 }, // 97 10010111
+    { 0, LINE_FOLLOW, 40 }, // 98 10011000
+    { 0, LINE_FOLLOW, 40 }, // 99 10011001
+    { 0, LINE_FOLLOW, 40 }, // 9A 10011010
+    { 0, LINE_FOLLOW, 40 }, // 9B 10011011
+    { 500, LINE_FOLLOW, 40 }, // 9C 10011100
+    { 500, LINE_FOLLOW, 40 }, // 9D 10011101
+    { 1000, LINE_FOLLOW, 40 }, // 9E 10011110
+    { 1500, LINE_FOLLOW, 40 }, // 9F 10011111
+    { -3500, LINE_FOLLOW, 40 }, // A0 10100000
+    { -3500, LINE_FOLLOW, 40 }, // A1 10100001
+    { -3500, LINE_FOLLOW, 40 }, // A2 10100010
+    { 3000, LINE_FOLLOW, 40 }, // A3 10100011
+    { -3500, LINE_FOLLOW, 40 }, // A4 10100100
+    { -3500, LINE_FOLLOW, 40 }, // A5 10100101
+    { 2000, LINE_FOLLOW, 40 }, // A6 10100110
+    { 2500, LINE_FOLLOW, 40 }, // A7 10100111
+    { -3500, LINE_FOLLOW, 40 }, // A8 10101000
+    { -3500, LINE_FOLLOW, 40 }, // A9 10101001
+    { -3500, LINE_FOLLOW, 40 }, // AA 10101010
+    { 3000, LINE_FOLLOW, 40 }, // AB 10101011
+    { 1000, LINE_FOLLOW, 40 }, // AC 10101100
+    { 1000, LINE_FOLLOW, 40 }, // AD 10101101
+    { 1500, LINE_FOLLOW, 40 }, // AE 10101110
+    { 2000, LINE_FOLLOW, 40 }, // AF 10101111
+    { -1000, LINE_FOLLOW, 40 }, // B0 10110000
+    { -1000, LINE_FOLLOW, 40 }, // B1 10110001
+    { -1000, LINE_FOLLOW, 40 }, // B2 10110010
+    { -1000, LINE_FOLLOW, 40 }, // B3 10110011
+    { -1000, LINE_FOLLOW, 40 }, // B4 10110100
+    { -1000, LINE_FOLLOW, 40 }, // B5 10110101
+    { -1000, LINE_FOLLOW, 40 }, // B6 10110110
+    { 2500, LINE_FOLLOW, 40 }, // B7 10110111
+    { -500, LINE_FOLLOW, 40 }, // B8 10111000
+    { -500, LINE_FOLLOW, 40 }, // B9 10111001
+    { -500, LINE_FOLLOW, 40 }, // BA 10111010
+    { -500, LINE_FOLLOW, 40 }, // BB 10111011
+    { 0, LINE_FOLLOW, 40 }, // BC 10111100
+    { 0, LINE_FOLLOW, 40 }, // BD 10111101
+    { 500, LINE_FOLLOW, 40 }, // BE 10111110
+    { 1000, LINE_FOLLOW, 40 }, // BF 10111111
+    { -3000, LINE_FOLLOW, 100 }, // C0 11000000
+    { -3000, LINE_FOLLOW, 40 }, // C1 11000001
+    { -3000, LINE_FOLLOW, 40 }, // C2 11000010
+    { -3000, LINE_FOLLOW, 40 }, // C3 11000011
+    { -3000, LINE_FOLLOW, 40 }, // C4 11000100
+    { -3000, LINE_FOLLOW, 40 }, // C5 11000101
+    { -3000, LINE_FOLLOW, 40 }, // C6 11000110
+    { 2500, LINE_FOLLOW, 40 }, // C7 11000111
+    { -3000, LINE_FOLLOW, 40 }, // C8 11001000
+    { -3000, LINE_FOLLOW, 40 }, // C9 11001001
+    { -3000, LINE_FOLLOW, 40 }, // CA 11001010
+    { -3000, LINE_FOLLOW, 40 }, // CB 11001011
+    { -3000, LINE_FOLLOW, 40 }, // CC 11001100
+    { -3000, LINE_FOLLOW, 40 }, // CD 11001101
+    { 1500, LINE_FOLLOW, 40 }, // CE 11001110
+    { 2000, LINE_FOLLOW, 40 }, // CF 11001111
+    { -3000, LINE_FOLLOW, 40 }, // D0 11010000
+    { -3000, LINE_FOLLOW, 40 }, // D1 11010001
+    { -3000, LINE_FOLLOW, 40 }, // D2 11010010
+    { -3000, LINE_FOLLOW, 40 }, // D3 11010011
+    { -3000, LINE_FOLLOW, 40 }, // D4 11010100
+    { -3000, LINE_FOLLOW, 40 }, // D5 11010101
+    { -3000, LINE_FOLLOW, 40 }, // D6 11010110
+    { 2500, LINE_FOLLOW, 40 }, // D7 11010111
+    { -3000, LINE_FOLLOW, 40 }, // D8 11011000
+    { -3000, LINE_FOLLOW, 40 }, // D9 11011001
+    { -3000, LINE_FOLLOW, 40 }, // DA 11011010
+    { -3000, LINE_FOLLOW, 40 }, // DB 11011011
+    { 500, LINE_FOLLOW, 40 }, // DC 11011100
+    { 500, LINE_FOLLOW, 40 }, // DD 11011101
+    { 1000, LINE_FOLLOW, 40 }, // DE 11011110
+    { 1500, LINE_FOLLOW, 40 }, // DF 11011111
+    { -2500, LINE_FOLLOW, 100 }, // E0 11100000
+    { -2500, LINE_FOLLOW, 40 }, // E1 11100001
+    { -2500, LINE_FOLLOW, 40 }, // E2 11100010
+    { -2500, LINE_FOLLOW, 40 }, // E3 11100011
+    { -2500, LINE_FOLLOW, 40 }, // E4 11100100
+    { -2500, LINE_FOLLOW, 40 }, // E5 11100101
+    { -2500, LINE_FOLLOW, 40 }, // E6 11100110
+    { -2500, LINE_FOLLOW, 40 }, // E7 11100111
+    { -2500, LINE_FOLLOW, 40 }, // E8 11101000
+    { -2500, LINE_FOLLOW, 40 }, // E9 11101001
+    { -2500, LINE_FOLLOW, 40 }, // EA 11101010
+    { -2500, LINE_FOLLOW, 40 }, // EB 11101011
+    { -2500, LINE_FOLLOW, 40 }, // EC 11101100
+    { -2500, LINE_FOLLOW, 40 }, // ED 11101101
+    { -2500, LINE_FOLLOW, 40 }, // EE 11101110
+    { 2000, LINE_FOLLOW, 40 }, // EF 11101111
+    { -2000, LINE_LEFT_BRANCH, 60 }, // F0 11110000
+    { -2000, LINE_FOLLOW, 40 }, // F1 11110001
+    { -2000, LINE_FOLLOW, 40 }, // F2 11110010
+    { -2000, LINE_FOLLOW, 40 }, // F3 11110011
+    { -2000, LINE_FOLLOW, 40 }, // F4 11110100
+    { -2000, LINE_FOLLOW, 40 }, // F5 11110101
+    { -2000, LINE_FOLLOW, 40 }, // F6 11110110
+    { -2000, LINE_FOLLOW, 40 }, // F7 11110111
+    { -1500, LINE_LEFT_BRANCH, 60 }, // F8 11111000
+    { -1500, LINE_FOLLOW, 40 }, // F9 11111001
+    { -1500, LINE_FOLLOW, 40 }, // FA 11111010
+    { -1500, LINE_FOLLOW, 40 }, // FB 11111011
+    { -1000, LINE_LEFT_BRANCH, 70 }, // FC 11111100
+    { -1000, LINE_FOLLOW, 40 }, // FD 11111101
+    { -500, LINE_INTERSECTION, 90 }, // FE 11111110
+    { 0, LINE_INTERSECTION, 100 }, // FF 11111111
+};
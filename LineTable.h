@@ -0,0 +1,28 @@
+#ifndef LINETABLE_H
+#define LINETABLE_H
+
+// What a line sensor pattern means. Generated from Tools/LineRules.txt into LineTable.c.
+enum LineEvent
+{
+    LINE_FOLLOW, // an ordinary line to steer on
+    LINE_LOST, // no line under any sensor
+    LINE_INTERSECTION, // a T or a 4-way intersection
+    LINE_LEFT_BRANCH, // a branch off to the left
+    LINE_RIGHT_BRANCH, // a branch off to the right
+    NUM_LINE_EVENTS
+};
+
+#define LINE_HOLD (-32768) // position of a pattern with no estimate; keep the last one
+
+// One entry of lineTable.
+struct LineClass
+{
+    int16_t position; // -3500 (left-most sensor) to 3500 (right-most sensor), or LINE_HOLD
+    uint8_t event; // enum LineEvent
+    uint8_t confidence; // 0 to 100
+};
+
+// Indexed by LineSensorSample.bits (bit 7 = left-most sensor).
+extern const struct LineClass lineTable[256];
+
+#endif
@@ -0,0 +1,90 @@
+
+#include "msp.h"
+#include "LineSensor.h"
+#include "MotionProfile.h"
+#include "LineTurn.h"
+#include "Encoder.h"
+#include "Motor.h"
+#include "Timebase.h"
+
+// Spins at the turn's speed until the new line is close, then slows so the middle sensors stop on it:
+//   - nothing counts until the robot is halfway round, so the line it is leaving doesn't end the turn;
+//   - within SLOW_DEGREES of where the line should be, the speed eases down towards ALIGN_SPEED;
+//   - once a sensor on the side the line comes from sees it, the speed drops with each sensor nearer the
+//     middle, and the turn ends when sensor 3 or 4 (the middle two) is black;
+//   - the turn gives up GIVE_UP_DEGREES past where the line should be, or after its time runs out.
+#define ALIGN_SPEED 80 // wheel speed as the line reaches the middle sensors, in mm/s
+#define TURN_ACCEL 3000 // mm/s^2; high, since the slow-down has only a sensor's width (8 degrees) to happen in
+#define SLOW_DEGREES 30 // start slowing this far before the line is expected
+#define GIVE_UP_DEGREES 60 // how far past the expected angle to keep looking
+#define TIMEOUT_MS(degrees) ((uint32_t)(degrees) * 25 + 1000) // about three times what the turn should take
+#define CENTER 0x18 // sensors 3 and 4
+
+// Starts a spin of about "degrees", to the right if positive and to the left if negative, that ends
+// with the middle sensors on a line. "speed" is the wheel speed (mm/s) while the line is still far off.
+// Call LineTurn_Step every control period until it's done. Measures from Encoder_Position, so it can be
+// called from an interrupt handler.
+void LineTurn_Start(struct LineTurn *turn, int16_t degrees, int16_t speed)
+{
+    turn->speed = (speed > ALIGN_SPEED) ? speed : ALIGN_SPEED;
+    turn->direction = (degrees > 0) ? 1 : -1;
+    turn->degrees = (degrees > 0) ? degrees : -degrees;
+    Encoder_Position(&turn->leftStart, &turn->rightStart);
+    turn->deadline = Timebase_Deadline(TIMEOUT_MS(turn->degrees) * 1000);
+    MotionProfile_Init(&turn->profile, turn->speed, TURN_ACCEL, 0);
+}
+
+// Returns how many sensors away from the middle the nearest black sensor on the "direction" side is
+// (1 to 3), or 0 if that side sees no line. Turning right, the line comes in from the right (bit 0).
+static int16_t Nearest(uint8_t bits, int8_t direction)
+{
+    int16_t i;
+    for (i = 1; i <= 3; i++)
+    {
+        if (bits & ((direction > 0) ? (0x08 >> i) : (0x10 << i)))
+        {
+            return i;
+        }
+    }
+    return 0;
+}
+
+// Moves the turn on by "ms" and stores the speed each wheel should go at in "left" and "right" (mm/s), for
+// the caller to pass to Motor_SetVelocity. "sample" is the latest line sensor reading, or 0 if there is no
+// new one. Reads Encoder_Position, so the main loop must keep the encoders updated.
+enum LineTurnResult LineTurn_Step(struct LineTurn *turn, const struct LineSensorSample *sample, uint16_t ms, int16_t *left, int16_t *right)
+{
+    int32_t leftNow, rightNow;
+    *left = 0;
+    *right = 0;
+    Encoder_Position(&leftNow, &rightNow);
+    int32_t turned = ((leftNow - turn->leftStart) - (rightNow - turn->rightStart)) * turn->direction
+            * ENCODER_UM_PER_TICK / (2 * MOTOR_SPIN_UM_PER_DEGREE); // degrees round so far
+    if (Motor_Halted() || (turned > turn->degrees + GIVE_UP_DEGREES) || Timebase_Expired(turn->deadline))
+    {
+        return LINETURN_LOST;
+    }
+    int32_t speed = turn->speed;
+    int32_t remaining = turn->degrees - turned;
+    if (remaining < SLOW_DEGREES)
+    {
+        speed = ALIGN_SPEED + ((remaining > 0) ? (turn->speed - ALIGN_SPEED) * remaining / SLOW_DEGREES : 0);
+    }
+    if (sample && (turned >= turn->degrees / 2))
+    {
+        if (sample->bits & CENTER)
+        {
+            return LINETURN_ALIGNED;
+        }
+        int16_t near = Nearest(sample->bits, turn->direction);
+        if (near && (ALIGN_SPEED + (turn->speed - ALIGN_SPEED) * (near - 1) / 3 < speed))
+        {
+            speed = ALIGN_SPEED + (turn->speed - ALIGN_SPEED) * (near - 1) / 3;
+        }
+    }
+    MotionProfile_Cruise(&turn->profile, speed);
+    int16_t v = MotionProfile_Step(&turn->profile, ms);
+    *left = turn->direction * v; // left wheel forward, right wheel backward to go right
+    *right = -turn->direction * v;
+    return LINETURN_RUNNING;
+}
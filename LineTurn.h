@@ -0,0 +1,25 @@
+#ifndef LINETURN_H
+#define LINETURN_H
+
+enum LineTurnResult
+{
+    LINETURN_RUNNING, // still turning
+    LINETURN_ALIGNED, // the middle sensors are on the new line; the speeds are 0
+    LINETURN_LOST // no line where it should have been, or the motors were halted; the speeds are 0
+};
+
+// A spin in place that ends on the line rather than at an angle. Fill in with LineTurn_Start.
+struct LineTurn
+{
+    int8_t direction; // 1 = right (clockwise), -1 = left
+    int16_t degrees; // how far round the line should be
+    int16_t speed; // wheel speed while the line is still far off, in mm/s
+    int32_t leftStart, rightStart; // encoder positions at the start
+    uint32_t deadline; // timebase tick to give up at
+    struct MotionProfile profile; // the wheel speed, eased between the turn and align speeds
+};
+
+void LineTurn_Start(struct LineTurn *turn, int16_t degrees, int16_t speed);
+enum LineTurnResult LineTurn_Step(struct LineTurn *turn, const struct LineSensorSample *sample, uint16_t ms, int16_t *left, int16_t *right);
+
+#endif
@@ -0,0 +1,154 @@
+
+#include "msp.h"
+#include "LineSensor.h"
+#include "Junction.h"
+#include "Maze.h"
+#include "Store.h"
+
+// The maze is explored with the left-hand rule, and every choice made at a junction (including
+// plain corners and turning back at dead ends) is logged as one 2-bit turn. The log is simplified as
+// it grows: a dead end shows up as "x B y" (go in with x, turn back, come out with y), which is the
+// same as taking the single turn x + 180 + y degrees at that junction. What is left when the goal is
+// reached is the route with every dead end cut out, which SOLUTIONING replays. It is kept in the
+// store, so after a power cycle the robot can replay it without exploring again.
+//
+// The turns are numbered so that their value times 90 is the angle turned clockwise, which makes
+// adding them up a matter of adding the numbers (mod 4).
+
+const char turnNames[4] = { 'S', 'R', 'B', 'L' };
+
+// The route as stored: the length, then 4 turns per byte, first turn in the low bits.
+static struct
+{
+    uint8_t length; // turns in the path
+    uint8_t turns[MAZE_MAX_PATH / 4];
+} route;
+static uint8_t overflow; // 1 if the maze had more junctions than the path can hold
+static uint8_t solved; // 1 once the goal was reached with a usable path
+static uint8_t next; // index of the next turn to replay
+
+// Stores turn i of the path.
+static void Set(uint8_t i, enum Turn turn)
+{
+    uint8_t shift = (i & 3) * 2;
+    route.turns[i >> 2] = (route.turns[i >> 2] & ~(3 << shift)) | (turn << shift);
+}
+
+// Returns turn i of the path.
+enum Turn Maze_PathTurn(uint8_t i)
+{
+    return (enum Turn)((route.turns[i >> 2] >> ((i & 3) * 2)) & 3);
+}
+
+// Returns the number of turns in the path.
+uint8_t Maze_PathLength(void)
+{
+    return route.length;
+}
+
+// Forgets the path, to explore a new maze.
+void Maze_Reset(void)
+{
+    route.length = 0;
+    overflow = 0;
+    solved = 0;
+    next = 0;
+}
+
+// Adds a turn to the path, folding out any dead end it closes.
+static void Record(enum Turn turn)
+{
+    if (route.length == MAZE_MAX_PATH)
+    {
+        overflow = 1;
+        return;
+    }
+    Set(route.length++, turn);
+    while ((route.length >= 3) && (Maze_PathTurn(route.length - 2) == TURN_BACK))
+    {
+        enum Turn merged = (enum Turn)((Maze_PathTurn(route.length - 3) + TURN_BACK + Maze_PathTurn(route.length - 1)) & 3);
+        route.length -= 2;
+        Set(route.length - 1, merged);
+    }
+}
+
+// Picks the way out of a junction by the left-hand rule and logs it.
+// exits: Input. EXIT_ bits of the junction (0 at the end of the line).
+enum Turn Maze_Explore(uint8_t exits)
+{
+    enum Turn turn;
+    if (exits & EXIT_LEFT)
+    {
+        turn = TURN_LEFT;
+    }
+    else if (exits & EXIT_STRAIGHT)
+    {
+        turn = TURN_STRAIGHT;
+    }
+    else if (exits & EXIT_RIGHT)
+    {
+        turn = TURN_RIGHT;
+    }
+    else
+    {
+        turn = TURN_BACK;
+    }
+    Record(turn);
+    return turn;
+}
+
+// Marks the current path as the solution and stores it. Call when the goal is reached.
+// Returns 1 if the path can be replayed, 0 if it overflowed.
+uint8_t Maze_Solved(void)
+{
+    solved = !overflow;
+    if (solved)
+    {
+        Store_Write(STORE_ROUTE, &route, sizeof(route));
+    }
+    return solved;
+}
+
+// Loads the solution stored by an earlier run, if there is one. Call once the store is set up.
+// Returns 1 if there is a solution to replay.
+uint8_t Maze_Load(void)
+{
+    Maze_Reset();
+    solved = Store_Read(STORE_ROUTE, &route, sizeof(route)) && (route.length <= MAZE_MAX_PATH);
+    if (!solved)
+    {
+        route.length = 0;
+    }
+    return solved;
+}
+
+// Rewinds the solution to its first turn. Returns 0 if there is no solution to replay.
+uint8_t Maze_StartReplay(void)
+{
+    next = 0;
+    return solved;
+}
+
+// Returns the next turn of the solution. If the robot is somewhere the solution doesn't fit
+// (it ran out, or the turn isn't one of the exits), it falls back on the left-hand rule.
+enum Turn Maze_Replay(uint8_t exits)
+{
+    static const uint8_t needs[4] = { EXIT_STRAIGHT, EXIT_RIGHT, 0, EXIT_LEFT };
+    if (next < route.length)
+    {
+        enum Turn turn = Maze_PathTurn(next++);
+        if ((exits & needs[turn]) || (turn == TURN_BACK))
+        {
+            return turn;
+        }
+    }
+    if (exits & EXIT_LEFT)
+    {
+        return TURN_LEFT;
+    }
+    if (exits & EXIT_STRAIGHT)
+    {
+        return TURN_STRAIGHT;
+    }
+    return (exits & EXIT_RIGHT) ? TURN_RIGHT : TURN_BACK;
+}
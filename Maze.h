@@ -0,0 +1,26 @@
+#ifndef MAZE_H
+#define MAZE_H
+
+// Which way to leave a junction, relative to the way the robot came in.
+enum Turn
+{
+    TURN_STRAIGHT,
+    TURN_RIGHT,
+    TURN_BACK,
+    TURN_LEFT
+};
+
+#define MAZE_MAX_PATH 128 // junctions the path log can hold (2 bits each)
+
+extern const char turnNames[4];
+
+void Maze_Reset(void);
+enum Turn Maze_Explore(uint8_t exits);
+uint8_t Maze_Solved(void);
+uint8_t Maze_Load(void);
+uint8_t Maze_StartReplay(void);
+enum Turn Maze_Replay(uint8_t exits);
+uint8_t Maze_PathLength(void);
+enum Turn Maze_PathTurn(uint8_t i);
+
+#endif
@@ -0,0 +1,215 @@
+
+#include "msp.h"
+#include "LineSensor.h"
+#include "MotionProfile.h"
+#include "Motor.h"
+#include "LineTurn.h"
+#include "Encoder.h"
+#include "Motion.h"
+#include "RamFunc.h"
+#include "Ring.h"
+#include "TimerAs.h"
+#include "TimerWheel.h"
+
+// The motion queue: main plans maneuvers and queues them, and a software timer (in the Timer A1
+// interrupt) runs them one after another, so main can get on with the next decision while the robot
+// moves. Commands go from main to the timer through a ring, so neither side turns interrupts off.
+//
+// main only writes head and the flush request; the timer only writes tail and what it is running.
+// The timer is only armed while there is something to do, so it doesn't hold the MCU out of LPM3.
+//
+// The timer doesn't touch the encoder queues or the speed loop, which belong to main: it measures from
+// Encoder_Position and leaves the wheel speeds it wants in "speeds", and main passes them on to the
+// motors with Motion_Drive each time it runs the speed loop. So Task_Speed must keep running, and
+// main must call Motion_Drive, while the queue is busy.
+#define QUEUE 8 // commands that can wait; a power of two
+#define STEP_MS ENCODER_PERIOD_MS // how often the running command is stepped
+
+static struct MotionCommand commands[QUEUE]; // main fills these and the timer runs them in order
+static struct Ring queue = RING_INIT(QUEUE);
+static uint16_t timer = TIMERWHEEL_NONE; // the software timer that steps the queue
+
+static volatile uint8_t running; // 1 while the timer has a command under way
+static struct MotionCommand current; // the command under way
+static struct MotorMove move; // its progress, for distance commands
+static struct LineTurn turn; // its progress, for line spins
+static uint32_t lastSequence; // the last line sensor sample passed to the line spin
+static volatile uint32_t speeds; // wheel speeds for Motion_Drive: left in the low half, right in the high; one write so main never sees half
+
+static volatile uint16_t flushTo; // queue head when main last asked for a flush
+static volatile uint16_t flushRequests; // flushes asked for by main
+static uint16_t flushesDone; // flushes carried out by the timer
+static volatile uint16_t failures; // commands that didn't finish
+
+// Empties the queue. Call once at start-up, before anything is queued.
+void Motion_Init(void)
+{
+    queue.head = 0;
+    queue.tail = 0;
+    running = 0;
+    speeds = 0;
+    flushTo = 0;
+    flushRequests = 0;
+    flushesDone = 0;
+}
+
+// Starts "command" as the one under way.
+static void Begin(const struct MotionCommand *command)
+{
+    current = *command;
+    if ((current.primitive == MOTION_SPIN) && (current.end == MOTION_UNTIL_LINE))
+    {
+        struct LineSensorSample sample;
+        LineTurn_Start(&turn, current.amount, current.speed);
+        lastSequence = LineSensor_Latest(&sample); // only act on samples read from now on
+    }
+    else if (current.primitive == MOTION_SPIN)
+    {
+        int8_t direction = (current.amount > 0) ? 1 : -1;
+        int32_t um = (int32_t)current.amount * direction * MOTOR_SPIN_UM_PER_DEGREE;
+        Motor_MoveStart(&move, direction, -direction, current.speed, um, MOTOR_MOVE_TIMEOUT_MS(um / 1000, current.speed)); // left wheel forward, right wheel backward to go right
+    }
+    else
+    {
+        int8_t direction = (current.primitive == MOTION_FORWARD) ? 1 : -1;
+        Motor_MoveStart(&move, direction, direction, current.speed, (int32_t)current.amount * 1000, MOTOR_MOVE_TIMEOUT_MS(current.amount, current.speed));
+    }
+    running = 1;
+}
+
+// Leaves "left" and "right" (mm/s) for the next Motion_Drive.
+static void Publish(int16_t left, int16_t right)
+{
+    speeds = (uint16_t)left | ((uint32_t)(uint16_t)right << 16);
+}
+
+// Moves the command under way on by "ms" and publishes the wheel speeds it wants.
+// Returns 1 while it's still going, 0 once it's over (with the speeds at 0).
+static uint8_t Continue(uint16_t ms)
+{
+    int16_t left, right;
+    uint8_t going;
+    if ((current.primitive == MOTION_SPIN) && (current.end == MOTION_UNTIL_LINE))
+    {
+        struct LineSensorSample sample;
+        uint32_t sequence = LineSensor_Latest(&sample); // main has the queue of samples, so peek at the newest
+        enum LineTurnResult result = LineTurn_Step(&turn, (sequence != lastSequence) ? &sample : 0, ms, &left, &right);
+        lastSequence = sequence;
+        if (result == LINETURN_LOST)
+        {
+            failures++;
+        }
+        going = (result == LINETURN_RUNNING);
+    }
+    else
+    {
+        enum MotorMoveResult result = Motor_MoveStep(&move, ms, &left, &right);
+        if (result == MOTORMOVE_FAILED)
+        {
+            failures++;
+        }
+        going = (result == MOTORMOVE_RUNNING);
+    }
+    Publish(left, right);
+    return going;
+}
+
+// Drops every queued command up to queue position "to".
+static void Drop(uint16_t to)
+{
+    while ((queue.tail != to) && (Ring_Front(&queue) >= 0))
+    {
+        Ring_Pop(&queue);
+    }
+}
+
+// Runs every STEP_MS in the Timer A1 interrupt while there is something to do: carries out any flush,
+// steps the command under way, and starts the next one as soon as it's over.
+static void Step(void)
+{
+    uint16_t requests = flushRequests;
+    if (requests != flushesDone)
+    {
+        __DMB(); // flushTo was written before the request that goes with it
+        Drop(flushTo);
+        if (running)
+        {
+            Publish(0, 0);
+            running = 0;
+        }
+        flushesDone = requests;
+    }
+    if (running)
+    {
+        uint16_t failed = failures;
+        if (Continue(STEP_MS))
+        {
+            return;
+        }
+        running = 0;
+        if (failures != failed) // the rest of the plan no longer fits where the robot is
+        {
+            Drop(queue.head);
+        }
+    }
+    int16_t slot = Ring_Front(&queue);
+    if (slot < 0) // nothing left, so stop ticking until main queues more
+    {
+        SoftTimer_Cancel(timer);
+        return;
+    }
+    Begin(&commands[slot]);
+    Ring_Pop(&queue);
+}
+
+// Queues "command" to start as soon as everything queued before it is done, and returns at once.
+// Returns 0 if the queue is full.
+uint8_t Motion_Enqueue(const struct MotionCommand *command)
+{
+    int16_t slot = Ring_Reserve(&queue);
+    if (slot < 0)
+    {
+        return 0;
+    }
+    commands[slot] = *command;
+    Ring_Publish(&queue);
+    if (!SoftTimer_Pending(timer)) // the timer stops itself when it runs out of commands
+    {
+        timer = SoftTimer_Start(Step, 1, STEP_MS);
+    }
+    return 1;
+}
+
+// Drops every queued command and stops the one under way, within STEP_MS. Commands queued after this
+// are kept.
+void Motion_Flush(void)
+{
+    flushTo = queue.head;
+    __DMB(); // the timer reads flushTo after it sees the request
+    flushRequests = flushRequests + 1;
+    if (!SoftTimer_Pending(timer))
+    {
+        timer = SoftTimer_Start(Step, 1, STEP_MS);
+    }
+}
+
+// Returns 1 while there are commands queued or under way (including a flush not yet carried out).
+uint8_t Motion_Busy(void)
+{
+    return (Ring_Count(&queue) != 0) || (flushRequests != flushesDone) || running; // in this order, since the timer pops a command before it starts it
+}
+
+// Sets the wheel speeds the queue last asked for. Call from the main loop, right before
+// Motor_VelocityUpdate, while the queue has the motors, and once more when it's done so the
+// last command's stop takes effect.
+RAMFUNC void Motion_Drive(void)
+{
+    uint32_t s = speeds;
+    Motor_SetVelocity((int16_t)(s & 0xFFFF), (int16_t)(s >> 16));
+}
+
+// Returns the number of commands that didn't finish: timed out, lost the line, or halted.
+uint16_t Motion_Failures(void)
+{
+    return failures;
+}
@@ -0,0 +1,34 @@
+#ifndef MOTION_H
+#define MOTION_H
+
+enum MotionPrimitive
+{
+    MOTION_FORWARD, // drive straight ahead "amount" mm
+    MOTION_BACKWARD, // drive straight back "amount" mm
+    MOTION_SPIN // spin in place "amount" degrees, to the right if positive and to the left if negative
+};
+
+enum MotionEnd
+{
+    MOTION_UNTIL_DISTANCE, // stop once the encoders have gone "amount"
+    MOTION_UNTIL_LINE // spins only: stop when the middle sensors are on a line about "amount" degrees round
+};
+
+// One maneuver for the queue. A command that fails (times out, loses the line, or is halted) drops the
+// commands queued after it, since they were planned from where it should have ended.
+struct MotionCommand
+{
+    enum MotionPrimitive primitive;
+    enum MotionEnd end;
+    int16_t speed; // peak wheel speed, in mm/s
+    int16_t amount; // mm or degrees
+};
+
+void Motion_Init(void);
+uint8_t Motion_Enqueue(const struct MotionCommand *command);
+void Motion_Flush(void);
+uint8_t Motion_Busy(void);
+void Motion_Drive(void);
+uint16_t Motion_Failures(void);
+
+#endif
@@ -0,0 +1,162 @@
+
+#include "msp.h"
+#include "MotionProfile.h"
+#include "RamFunc.h"
+
+#define FINISH_UM 1000 // a move this close to its target, and slow enough to stop in one tick, is finished
+
+// Returns the integer square root of n (rounded down).
+// Takes 64 bits because 2 a d and 2 j dv pass 32 bits at the larger limits.
+RAMFUNC static uint32_t SquareRoot(uint64_t n)
+{
+    uint64_t root = 0;
+    uint64_t bit = 1ull << 62;
+    while (bit > n)
+    {
+        bit >>= 2;
+    }
+    while (bit)
+    {
+        if (n >= root + bit)
+        {
+            n -= root + bit;
+            root = (root >> 1) + bit;
+        }
+        else
+        {
+            root >>= 1;
+        }
+        bit >>= 2;
+    }
+    return root;
+}
+
+// Limits value to the range -limit to limit.
+RAMFUNC static int32_t Clamp(int32_t value, int32_t limit)
+{
+    if (value > limit)
+    {
+        return limit;
+    }
+    if (value < -limit)
+    {
+        return -limit;
+    }
+    return value;
+}
+
+// Sets the limits and starts the profile at rest at position 0, holding a cruise speed of 0.
+void MotionProfile_Init(struct MotionProfile *p, int32_t maxSpeed, int32_t maxAccel, int32_t maxJerk)
+{
+    p->maxSpeed = maxSpeed;
+    p->maxAccel = maxAccel;
+    p->maxJerk = maxJerk;
+    p->position = 0;
+    p->velocity = 0;
+    p->accel = 0;
+    p->target = 0;
+    p->cruise = 0;
+    p->remainder = 0;
+    p->positioning = 0;
+    p->done = 0;
+}
+
+// Moves to "target" (um) and stops there. Can be called mid-move to change the target;
+// the profile carries on from its current speed and acceleration.
+void MotionProfile_MoveTo(struct MotionProfile *p, int32_t target)
+{
+    p->target = target;
+    p->positioning = 1;
+    p->done = 0;
+}
+
+// Accelerates to "speed" (mm/s, negative = backward) and holds it until told otherwise.
+void MotionProfile_Cruise(struct MotionProfile *p, int16_t speed)
+{
+    p->cruise = Clamp(speed, p->maxSpeed);
+    p->positioning = 0;
+    p->done = 0;
+}
+
+// Advances the profile by "ms" milliseconds and returns the speed setpoint in mm/s.
+RAMFUNC int16_t MotionProfile_Step(struct MotionProfile *p, uint16_t ms)
+{
+    int32_t wanted; // speed to head for, in um/s
+    if (p->positioning)
+    {
+        if (p->done)
+        {
+            return 0;
+        }
+        int32_t remaining = p->target - p->position;
+        int32_t distance = (remaining < 0) ? -remaining : remaining;
+        int32_t speed = (p->velocity < 0) ? -p->velocity : p->velocity;
+        if ((distance <= FINISH_UM) && (speed <= p->maxAccel * ms))
+        {
+            p->position = p->target;
+            p->velocity = 0;
+            p->accel = 0;
+            p->remainder = 0;
+            p->done = 1;
+            return 0;
+        }
+        // Brake along v = sqrt(2 a d). With a jerk limit, the deceleration takes a / j seconds to build up,
+        // so start braking that much travel earlier.
+        if (p->maxJerk)
+        {
+            int32_t lead = (speed / 1000) * p->maxAccel / p->maxJerk * 500;
+            distance = (distance > lead) ? distance - lead : 0;
+        }
+        int32_t braking = SquareRoot(2ull * p->maxAccel * (distance / 1000)); // mm/s
+        if (braking > p->maxSpeed)
+        {
+            braking = p->maxSpeed;
+        }
+        wanted = ((remaining < 0) ? -braking : braking) * 1000;
+    }
+    else
+    {
+        wanted = p->cruise * 1000;
+    }
+
+    // Acceleration that would reach the wanted speed this tick, within the limit.
+    // um/s per ms is mm/s^2.
+    int32_t change = wanted - p->velocity;
+    int32_t accel = Clamp(change / ms, p->maxAccel);
+    if (p->maxJerk)
+    {
+        // Ease off early enough that the acceleration can fall to 0 at the jerk limit
+        // just as the speed arrives: a = sqrt(2 j dv).
+        int32_t gap = ((change < 0) ? -change : change) / 1000;
+        int32_t easing = SquareRoot(2ull * p->maxJerk * gap);
+        accel = Clamp(accel, easing ? easing : 1);
+        int32_t step = p->maxJerk * ms / 1000;
+        if (step == 0)
+        {
+            step = 1;
+        }
+        accel = p->accel + Clamp(accel - p->accel, step);
+    }
+    p->accel = accel;
+
+    int32_t last = p->velocity;
+    p->velocity += accel * ms;
+    if (((accel > 0) && (p->velocity > wanted)) || ((accel < 0) && (p->velocity < wanted))) // don't overshoot
+    {
+        p->velocity = wanted;
+        p->accel = 0;
+    }
+
+    // Trapezoidal integration of the speed over the tick; keep the fraction of a um for next time.
+    int32_t travel = (last + p->velocity) / 2 * ms + p->remainder;
+    p->position += travel / 1000;
+    p->remainder = travel % 1000;
+
+    return (p->velocity + ((p->velocity < 0) ? -500 : 500)) / 1000;
+}
+
+// Returns 1 once a MoveTo has stopped at its target.
+uint8_t MotionProfile_Done(const struct MotionProfile *p)
+{
+    return p->done;
+}
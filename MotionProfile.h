@@ -0,0 +1,29 @@
+#ifndef MOTIONPROFILE_H
+#define MOTIONPROFILE_H
+
+// An acceleration- and jerk-limited setpoint generator, stepped once per control tick.
+// Distances are in um and speeds in mm/s, so a linear move uses the wheel travel directly and a spin
+// uses each wheel's arc. Speed is kept internally in um/s so small accelerations aren't lost to rounding.
+struct MotionProfile
+{
+    int32_t maxSpeed; // mm/s
+    int32_t maxAccel; // mm/s^2
+    int32_t maxJerk; // mm/s^3, or 0 for no jerk limit (trapezoid instead of S-curve)
+
+    int32_t position; // um from where the profile was started
+    int32_t velocity; // um/s
+    int32_t accel; // mm/s^2
+    int32_t target; // um, when positioning
+    int32_t cruise; // mm/s, when not positioning
+    int32_t remainder; // position not yet added, in um * 1000
+    uint8_t positioning; // 1 to stop at target, 0 to hold cruise
+    uint8_t done; // 1 once a move has stopped at its target
+};
+
+void MotionProfile_Init(struct MotionProfile *p, int32_t maxSpeed, int32_t maxAccel, int32_t maxJerk);
+void MotionProfile_MoveTo(struct MotionProfile *p, int32_t target);
+void MotionProfile_Cruise(struct MotionProfile *p, int16_t speed);
+int16_t MotionProfile_Step(struct MotionProfile *p, uint16_t ms);
+uint8_t MotionProfile_Done(const struct MotionProfile *p);
+
+#endif
@@ -95,18 +95,54 @@ policies, either expressed or implied, of the FreeBSD Project.
  */
 
 #include "msp.h"
+#include "MotionProfile.h"
 #include "Motor.h"
 #include "Clock.h"
-
-#define PWM_SCALE 8 // used in the motor functions to make PWM smoother (not so clicky). Higher scale = increased smoothness but higher minimum duty.
-
-// Initializes the 6 GPIO lines for the motors and puts driver to sleep.
-void Motor_InitSimple()
+#include "Encoder.h"
+#include "Timebase.h"
+#include "RamFunc.h"
+
+// Timer A0 runs in up mode from SMCLK (12MHz), so one PWM period is PWM_PERIOD counts (1.2kHz).
+// Duty values use the same 0 to 10000 units as the period, so a duty can be written straight into a compare register.
+#define PWM_PERIOD 10000
+
+#define SPIN_SPEED 300 // top wheel speed in the spin functions, in mm/s
+#define MOVE_ACCEL 1500 // acceleration limit for moves and spins, in mm/s^2
+#define MOVE_JERK 30000 // jerk limit for moves and spins, in mm/s^3 (reaches full acceleration in 50ms)
+#define CREEP_SPEED 50 // speed to finish a move at if the wheels are still short when the profile ends, in mm/s
+
+// Speed control gains, scaled by 1/100. The error is in mm/s and the output in duty.
+#define VELOCITY_KP 400 // duty per mm/s of error
+#define VELOCITY_KI 40 // duty per mm/s of error, added to the integral on every update
+#define INTEGRAL_LIMIT (PWM_PERIOD / 2 * 100) // the integral can trim the feed-forward by at most half of full duty
+
+// Feed-forward: the duty that holds each speed (0, 100, 200, ... mm/s) on a level floor.
+// Below about 800 the motors don't turn at all. Re-measure for different motors or wheels.
+#define FEED_FORWARD_STEP 100
+static const int16_t feedForward[] = { 0, 1950, 3100, 4250, 5400, 6550, 7700, 8850, 10000 };
+#define FEED_FORWARD_ENTRIES (sizeof(feedForward) / sizeof(feedForward[0]))
+
+// State of one wheel's speed controller.
+struct SpeedLoop
+{
+    int16_t target; // mm/s, + forward
+    int32_t integral; // duty * 100
+};
+
+static struct SpeedLoop leftLoop, rightLoop;
+static uint8_t velocityMode; // 1 while Motor_VelocityUpdate drives the motors
+static int16_t leftDuty, rightDuty; // what Output last wrote, + forward
+static volatile uint8_t halted; // 1 from Motor_Halt until Motor_Release; the motors stay off meanwhile
+
+// Initializes the 6 GPIO lines for the motors and Timer A0 for PWM, and puts driver to sleep.
+// P2.6 (right PWM) is TA0.3 and P2.7 (left PWM) is TA0.4.
+// P5.4 and P5.5 are the left and right direction pins.
+// P3.6 and P3.7 are the right and left sleep pins.
+void Motor_Init()
 {
-    // Initialize P1.6 and P1.7 and make them outputs
     P5->SEL0 &= ~0x30; // GPIOs
     P5->SEL1 &= ~0x30;
-    P2->SEL0 &= ~0xC0; // GPIOs
+    P2->SEL0 |= 0xC0; // primary module function (TA0.3 and TA0.4)
     P2->SEL1 &= ~0xC0;
     P3->SEL0 &= ~0xC0; // GPIOs
     P3->SEL1 &= ~0xC0;
@@ -116,16 +152,216 @@ void Motor_InitSimple()
     P3->DIR |= 0xC0; // outputs
 
     P5->OUT &= ~0x30; // direction = 0 (forward)
-    P2->OUT &= ~0xC0; // PWM = 0
     P3->OUT &= ~0xC0; // sleep = 0
+
+    TIMER_A0->CTL &= ~0x0030; // stop Timer A0
+    TIMER_A0->CCR[0] = PWM_PERIOD - 1; // PWM period
+    TIMER_A0->EX0 = 0; // no extra clock divider
+    TIMER_A0->CCTL[3] = 0x00E0; // output mode 7 (reset/set), no interrupts
+    TIMER_A0->CCTL[4] = 0x00E0; // output mode 7 (reset/set), no interrupts
+    TIMER_A0->CCR[3] = 0; // right duty = 0
+    TIMER_A0->CCR[4] = 0; // left duty = 0
+    TIMER_A0->CTL = 0x0214; // SMCLK, divider /1, up mode, reset and start Timer A0
+}
+
+// Writes the duty of both motors (-10000 to 10000) to the hardware.
+// A negative duty drives that motor backward; a duty of 0 puts that motor's driver to sleep.
+RAMFUNC static void Output(int16_t left, int16_t right)
+{
+    if (halted)
+    {
+        left = 0;
+        right = 0;
+    }
+    if (left < 0) // if the left motor should go backward
+    {
+        P5->OUT |= 0x10; // left motor backward
+        left = -left;
+    }
+    else
+    {
+        P5->OUT &= ~0x10; // left motor forward
+    }
+    if (right < 0) // if the right motor should go backward
+    {
+        P5->OUT |= 0x20; // right motor backward
+        right = -right;
+    }
+    else
+    {
+        P5->OUT &= ~0x20; // right motor forward
+    }
+    if (left > PWM_PERIOD)
+    {
+        left = PWM_PERIOD;
+    }
+    if (right > PWM_PERIOD)
+    {
+        right = PWM_PERIOD;
+    }
+
+    TIMER_A0->CCR[4] = left; // left duty
+    TIMER_A0->CCR[3] = right; // right duty
+    leftDuty = (P5->OUT & 0x10) ? -left : left;
+    rightDuty = (P5->OUT & 0x20) ? -right : right;
+
+    if (left) // only wake the drivers that are actually driving
+    {
+        P3->OUT |= 0x80; // left motor don't sleep
+    }
+    else
+    {
+        P3->OUT &= ~0x80; // left motor sleep
+    }
+    if (right)
+    {
+        P3->OUT |= 0x40; // right motor don't sleep
+    }
+    else
+    {
+        P3->OUT &= ~0x40; // right motor sleep
+    }
+    if (halted) // Motor_Halt interrupted this part way, so some of the writes above may have undone it
+    {
+        Motor_Halt();
+    }
+}
+
+// Turns both motors off at once and keeps them off, whatever else is asked of them, until Motor_Release.
+// Safe to call from any interrupt handler. Returns 1 if the motors were already halted.
+RAMFUNC uint8_t Motor_Halt(void)
+{
+    TIMER_A0->CCR[4] = 0; // left duty = 0
+    TIMER_A0->CCR[3] = 0; // right duty = 0
+    P3->OUT &= ~0xC0; // both drivers sleep
+    uint8_t was = halted;
+    halted = 1;
+    velocityMode = 0;
+    leftDuty = 0;
+    rightDuty = 0;
+    return was;
+}
+
+// Lets the motors be driven again after Motor_Halt. They stay off until the next Motor_SetDuty or Motor_SetVelocity.
+void Motor_Release(void)
+{
+    halted = 0;
+}
+
+// Returns 1 while the motors are halted.
+uint8_t Motor_Halted(void)
+{
+    return halted;
+}
+
+// Sets the duty of both motors (-10000 to 10000) and returns immediately.
+// A negative duty drives that motor backward; a duty of 0 puts that motor's driver to sleep.
+// The PWM keeps running in hardware until the next call. Turns speed control off.
+void Motor_SetDuty(int16_t left, int16_t right)
+{
+    velocityMode = 0;
+    Output(left, right);
+}
+
+// Returns the duty that holds "speed" (mm/s) with no correction, interpolated from the feed-forward table.
+RAMFUNC static int32_t FeedForward(int16_t speed)
+{
+    int32_t s = (speed < 0) ? -speed : speed;
+    uint16_t i = s / FEED_FORWARD_STEP;
+    int32_t duty;
+    if (i >= FEED_FORWARD_ENTRIES - 1)
+    {
+        duty = feedForward[FEED_FORWARD_ENTRIES - 1];
+    }
+    else
+    {
+        duty = feedForward[i] + (feedForward[i + 1] - feedForward[i]) * (s - i * FEED_FORWARD_STEP) / FEED_FORWARD_STEP;
+    }
+    return (speed < 0) ? -duty : duty;
+}
+
+// Runs one update of a wheel's PI speed controller and returns the duty for that wheel.
+RAMFUNC static int16_t SpeedStep(struct SpeedLoop *loop, int16_t measured)
+{
+    int32_t error = loop->target - measured;
+    int32_t duty = FeedForward(loop->target) + (VELOCITY_KP * error + loop->integral) / 100;
+
+    // Anti-windup: stop integrating once the output is saturated in the direction the error pushes.
+    if (!((duty >= PWM_PERIOD) && (error > 0)) && !((duty <= -PWM_PERIOD) && (error < 0)))
+    {
+        loop->integral += VELOCITY_KI * error;
+        if (loop->integral > INTEGRAL_LIMIT)
+        {
+            loop->integral = INTEGRAL_LIMIT;
+        }
+        else if (loop->integral < -INTEGRAL_LIMIT)
+        {
+            loop->integral = -INTEGRAL_LIMIT;
+        }
+    }
+    if (duty > PWM_PERIOD)
+    {
+        duty = PWM_PERIOD;
+    }
+    else if (duty < -PWM_PERIOD)
+    {
+        duty = -PWM_PERIOD;
+    }
+    return duty;
+}
+
+// Sets the speed of each wheel in mm/s (negative = backward) and turns speed control on.
+// The motors follow it from the next Motor_VelocityUpdate. Both 0 lets the drivers sleep.
+RAMFUNC void Motor_SetVelocity(int16_t left, int16_t right)
+{
+    if (!velocityMode) // coming from open-loop duty, start the integrators fresh
+    {
+        leftLoop.integral = 0;
+        rightLoop.integral = 0;
+    }
+    leftLoop.target = left;
+    rightLoop.target = right;
+    velocityMode = 1;
+}
+
+// Runs the per-wheel speed controllers on the latest encoder speeds. Call right after Encoder_Update,
+// every ENCODER_PERIOD_MS. Does nothing unless Motor_SetVelocity turned speed control on.
+RAMFUNC void Motor_VelocityUpdate(void)
+{
+    if (!velocityMode)
+    {
+        return;
+    }
+    if ((leftLoop.target == 0) && (rightLoop.target == 0)) // parked
+    {
+        leftLoop.integral = 0;
+        rightLoop.integral = 0;
+        Output(0, 0);
+        return;
+    }
+    int16_t left, right;
+    Encoder_Speed(&left, &right);
+    Output(SpeedStep(&leftLoop, left), SpeedStep(&rightLoop, right));
+}
+
+// Stores the duty each motor is driven at (-10000 to 10000, + forward).
+void Motor_GetDuty(int16_t *left, int16_t *right)
+{
+    *left = leftDuty;
+    *right = rightDuty;
+}
+
+// Stores the speed each wheel is being held at in mm/s, or 0 when speed control is off.
+void Motor_GetVelocity(int16_t *left, int16_t *right)
+{
+    *left = velocityMode ? leftLoop.target : 0;
+    *right = velocityMode ? rightLoop.target : 0;
 }
 
 // Stops both motors, puts driver to sleep.
 void Motor_StopSimple(void)
 {
-    P5->OUT &= ~0x30; // direction = 0 (forward)
-    P2->OUT &= ~0xC0; // PWM = 0
-    P3->OUT &= ~0xC0; // low current sleep mode
+    Motor_SetDuty(0, 0);
 }
 
 // Drives both motors forward at duty (100 to 9900).
@@ -133,19 +369,9 @@ void Motor_StopSimple(void)
 // Returns after time*10ms.
 void Motor_ForwardSimple(uint16_t duty, uint32_t time)
 {
-    P5->OUT &= ~0x30; // both motors forward
-    P3->OUT |= 0xC0; // don't sleep
-    uint16_t duty1 = 10000 - duty;
-
-    int i;
-    int max = 0.23 * time * PWM_SCALE;
-    for (i = 0; i < max; i++) // run max times
-    {
-        P2->OUT |= 0xC0; // turn the motor on
-        Clock_Delay1us(1.0f * duty / 10000 * 48 / PWM_SCALE * 1000);
-        P2->OUT &= ~0xC0; // turn the motor off
-        Clock_Delay1us(1.0f * duty1 / 10000 * 48 / PWM_SCALE * 1000);
-    }
+    Motor_SetDuty(duty, duty); // both motors forward
+    Clock_Delay1ms(10 * time);
+    Motor_SetDuty(0, 0);
 }
 
 // Drives both motors backward at duty (100 to 9900).
@@ -153,19 +379,9 @@ void Motor_ForwardSimple(uint16_t duty, uint32_t time)
 // Returns after time*10ms.
 void Motor_BackwardSimple(uint16_t duty, uint32_t time)
 {
-    P5->OUT |= 0x30; // both motors backward
-    P3->OUT |= 0xC0; // don't sleep
-    uint16_t duty1 = 10000 - duty;
-
-    int i;
-    int max = 0.23 * time * PWM_SCALE;
-    for (i = 0; i < max; i++) // run max times
-    {
-        P2->OUT |= 0xC0; // turn the motor on
-        Clock_Delay1us(1.0f * duty / 10000 * 48 / PWM_SCALE * 1000);
-        P2->OUT &= ~0xC0; // turn the motor off
-        Clock_Delay1us(1.0f * duty1 / 10000 * 48 / PWM_SCALE * 1000);
-    }
+    Motor_SetDuty(-duty, -duty); // both motors backward
+    Clock_Delay1ms(10 * time);
+    Motor_SetDuty(0, 0);
 }
 
 // Drives just the left motor forward at duty (100 to 9900).
@@ -174,20 +390,9 @@ void Motor_BackwardSimple(uint16_t duty, uint32_t time)
 // Returns after time*10ms.
 void Motor_LeftSimple(uint16_t duty, uint32_t time)
 {
-    P5->OUT &= ~0b10000; // left motor forward
-    P3->OUT |= 0x80; // left motor don't sleep
-    P2->OUT &= ~0x40; // stop right motor
-    uint16_t duty1 = 10000 - duty;
-
-    int i;
-    int max = 0.23 * time * PWM_SCALE;
-    for (i = 0; i < max; i++) // run max times
-    {
-        P2->OUT |= 0x80; // turn the motor on
-        Clock_Delay1us(1.0f * duty / 10000 * 48 / PWM_SCALE * 1000);
-        P2->OUT &= ~0x80; // turn the motor off
-        Clock_Delay1us(1.0f * duty1 / 10000 * 48 / PWM_SCALE * 1000);
-    }
+    Motor_SetDuty(duty, 0); // left motor forward, right motor stopped
+    Clock_Delay1ms(10 * time);
+    Motor_SetDuty(0, 0);
 }
 
 // Drives just the right motor forward at duty (100 to 9900).
@@ -196,105 +401,93 @@ void Motor_LeftSimple(uint16_t duty, uint32_t time)
 // Returns after time*10ms.
 void Motor_RightSimple(uint16_t duty, uint32_t time)
 {
-    P5->OUT &= ~0b1000; // right motor forward
-    P3->OUT |= 0x40; // right motor don't sleep
-    P2->OUT &= ~0x80; // stop left motor
-    uint16_t duty1 = 10000 - duty;
-
-    int i;
-    int max = 0.23 * time * PWM_SCALE;
-    for (i = 0; i < max; i++) // run max times
-    {
-        P2->OUT |= 0x40; // turn the motor on
-        Clock_Delay1us(1.0f * duty / 10000 * 48 / PWM_SCALE * 1000);
-        P2->OUT &= ~0x40; // turn the motor off
-        Clock_Delay1us(1.0f * duty1 / 10000 * 48 / PWM_SCALE * 1000);
-    }
+    Motor_SetDuty(0, duty); // right motor forward, left motor stopped
+    Clock_Delay1ms(10 * time);
+    Motor_SetDuty(0, 0);
 }
 
-// Spins the robot to the right by 90 degrees using both wheels.
-void Motor_SpinRight90()
+// Starts moving each wheel "um" of travel along a speed profile that peaks at "speed" mm/s.
+// "leftSign" and "rightSign" (1 or -1) give each wheel's direction. The profile sets the speed; the encoders
+// decide where each wheel stops, and a wheel that gets there first is stopped while the other one finishes.
+// Gives up after "timeout" ms (a stuck wheel). Call Motor_MoveStep every ENCODER_PERIOD_MS until it's done.
+// Measures from Encoder_Position, so it can be called from an interrupt handler.
+void Motor_MoveStart(struct MotorMove *move, int8_t leftSign, int8_t rightSign, int16_t speed, int32_t um, uint32_t timeout)
 {
-    P5->OUT &= ~0b100000; // left motor forward
-    P5->OUT |= 0b10000; // right motor backward
-    P3->OUT |= 0xC0; // both motors don't sleep
+    move->leftSign = leftSign;
+    move->rightSign = rightSign;
+    move->ticks = um / ENCODER_UM_PER_TICK;
+    move->leftDone = 0;
+    move->rightDone = 0;
+    move->deadline = Timebase_Deadline(timeout * 1000);
+    MotionProfile_Init(&move->profile, speed, MOVE_ACCEL, MOVE_JERK);
+    MotionProfile_MoveTo(&move->profile, um);
+    Encoder_Position(&move->leftStart, &move->rightStart);
+}
 
-    int i;
-    int max = 0.23 * 47 * PWM_SCALE;
-    for (i = 0; i < max; i++) // run max times
+// Moves the move on by "ms" and stores the speed each wheel should go at in "left" and "right" (mm/s), for
+// the caller to pass to Motor_SetVelocity. Stores 0s and returns MOTORMOVE_DONE once both wheels are there,
+// or MOTORMOVE_FAILED if the move timed out or Motor_Halt stopped the motors. Reads Encoder_Position, so
+// the main loop must keep the encoders updated; it can be called from an interrupt handler.
+enum MotorMoveResult Motor_MoveStep(struct MotorMove *move, uint16_t ms, int16_t *left, int16_t *right)
+{
+    int32_t leftNow, rightNow;
+    *left = 0;
+    *right = 0;
+    if (Timebase_Expired(move->deadline) || halted)
     {
-        P2->OUT |= 0xC0; // turn both motors on
-        Clock_Delay1ms(1.0f * 3500 / 10000 * 48 / PWM_SCALE);
-        P2->OUT &= ~0xC0; // turn both motors off
-        Clock_Delay1ms(1.0f * 6400 / 10000 * 48 / PWM_SCALE);
+        return MOTORMOVE_FAILED;
     }
-}
-void Motor_SpinRight45()
-{
-    P5->OUT &= ~0b100000; // left motor forward
-    P5->OUT |= 0b10000; // right motor backward
-    P3->OUT |= 0xC0; // both motors don't sleep
-
-    int i;
-    int max = 0.23 * 47 * PWM_SCALE/2;
-    for (i = 0; i < max; i++) // run max times
+    int16_t v = MotionProfile_Step(&move->profile, ms);
+    if (MotionProfile_Done(&move->profile)) // the wheels lagged the profile; creep the rest of the way
     {
-        P2->OUT |= 0xC0; // turn both motors on
-        Clock_Delay1ms(1.0f * 3500 / 10000 * 48 / PWM_SCALE);
-        P2->OUT &= ~0xC0; // turn both motors off
-        Clock_Delay1ms(1.0f * 6400 / 10000 * 48 / PWM_SCALE);
+        v = CREEP_SPEED;
     }
-}
-
-// Spins the robot to the left by 90 degrees using both wheels.
-void Motor_SpinLeft90()
-{
-    P5->OUT &= ~0b10000; // right motor forward
-    P5->OUT |= 0b100000; // left motor backward
-    P3->OUT |= 0xC0; // both motors don't sleep
-
-    int i;
-    int max = 0.23 * 47 * PWM_SCALE;
-    for (i = 0; i < max; i++) // run max times
+    Encoder_Position(&leftNow, &rightNow);
+    move->leftDone = move->leftDone || (leftNow - move->leftStart >= move->ticks) || (move->leftStart - leftNow >= move->ticks);
+    move->rightDone = move->rightDone || (rightNow - move->rightStart >= move->ticks) || (move->rightStart - rightNow >= move->ticks);
+    if (move->leftDone && move->rightDone)
     {
-        P2->OUT |= 0xC0; // turn both motors on
-        Clock_Delay1ms(1.0f * 3500 / 10000 * 48 / PWM_SCALE);
-        P2->OUT &= ~0xC0; // turn both motors off
-        Clock_Delay1ms(1.0f * 6400 / 10000 * 48 / PWM_SCALE);
+        return MOTORMOVE_DONE;
     }
+    *left = move->leftDone ? 0 : move->leftSign * v;
+    *right = move->rightDone ? 0 : move->rightSign * v;
+    return MOTORMOVE_RUNNING;
 }
 
-void Motor_SpinLeft45()
+// Moves each wheel "um" of travel, as Motor_MoveStart, and blocks until it's done.
+// Runs the speed loop itself every ENCODER_PERIOD_MS, since the scheduler doesn't run during a blocking move.
+// Returns 1 if both wheels got there, or 0 if the move timed out or Motor_Halt stopped the motors.
+static uint8_t Travel(int8_t leftSign, int8_t rightSign, int16_t speed, int32_t um, uint32_t timeout)
 {
-    P5->OUT &= ~0b10000; // right motor forward
-    P5->OUT |= 0b100000; // left motor backward
-    P3->OUT |= 0xC0; // both motors don't sleep
-
-    int i;
-    int max = 0.23 * 47 * PWM_SCALE / 2;
-    for (i = 0; i < max; i++) // run max times
+    struct MotorMove move;
+    enum MotorMoveResult result = MOTORMOVE_RUNNING;
+    int32_t leftTicks, rightTicks;
+    int16_t left, right;
+    Encoder_Read(&leftTicks, &rightTicks); // count the latest edges, so the move starts from where the wheels are
+    Motor_MoveStart(&move, leftSign, rightSign, speed, um, timeout);
+    while (result == MOTORMOVE_RUNNING)
     {
-        P2->OUT |= 0xC0; // turn both motors on
-        Clock_Delay1ms(1.0f * 3500 / 10000 * 48 / PWM_SCALE);
-        P2->OUT &= ~0xC0; // turn both motors off
-        Clock_Delay1ms(1.0f * 6400 / 10000 * 48 / PWM_SCALE);
+        uint32_t next = Timebase_Deadline(ENCODER_PERIOD_MS * 1000);
+        Encoder_Update();
+        result = Motor_MoveStep(&move, ENCODER_PERIOD_MS, &left, &right);
+        Motor_SetVelocity(left, right);
+        Motor_VelocityUpdate();
+        Timebase_WaitUntil(next);
     }
+    Motor_SetDuty(0, 0);
+    return result == MOTORMOVE_DONE;
 }
 
-// Spins the robot 180 degrees.
-void Motor_Spin180()
+// Spins the robot in place by "degrees", to the right if positive and to the left if negative.
+// The turn angle comes from the encoders, so it doesn't change with the battery or the floor.
+// Returns 1 when the angle is reached, or 0 if the spin timed out first.
+uint8_t Motor_Spin(int16_t degrees)
 {
-    P5->OUT &= ~0b100000; // left motor forward
-    P5->OUT |= 0b10000; // right motor backward
-    P3->OUT |= 0xC0; // both motors don't sleep
-
-    int i;
-    int max = 0.27 * 95 * PWM_SCALE;
-    for (i = 0; i < max; i++) // run max times
+    int8_t direction = (degrees > 0) ? 1 : -1;
+    if (degrees < 0)
     {
-        P2->OUT |= 0xC0; // turn both motors on
-        Clock_Delay1ms(1.0f * 3500 / 10000 * 48 / PWM_SCALE);
-        P2->OUT &= ~0xC0; // turn both motors off
-        Clock_Delay1ms(1.0f * 6400 / 10000 * 48 / PWM_SCALE);
+        degrees = -degrees;
     }
+    int32_t um = (int32_t)degrees * MOTOR_SPIN_UM_PER_DEGREE;
+    return Travel(direction, -direction, SPIN_SPEED, um, MOTOR_MOVE_TIMEOUT_MS(um / 1000, SPIN_SPEED)); // left wheel forward, right wheel backward to go right
 }
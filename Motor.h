@@ -1,10 +1,43 @@
+#ifndef MOTOR_H
+#define MOTOR_H
 
-void Motor_InitSimple(void);
+#define MOTOR_SPIN_UM_PER_DEGREE 1222 // each wheel's travel per degree of spin: pi * 140mm wheel base / 360
+#define MOTOR_MOVE_TIMEOUT_MS(mm, speed) ((uint32_t)(mm) * 3000 / (speed) + 500) // about three times the time a move takes
+
+enum MotorMoveResult
+{
+    MOTORMOVE_RUNNING, // still moving
+    MOTORMOVE_DONE, // both wheels got there; the speeds are 0
+    MOTORMOVE_FAILED // timed out, or the motors were halted; the speeds are 0
+};
+
+// A move of each wheel by a distance, measured by the encoders. Fill in with Motor_MoveStart.
+struct MotorMove
+{
+    int8_t leftSign, rightSign; // each wheel's direction: 1 forward, -1 backward
+    int32_t ticks; // how far each wheel goes, in encoder ticks
+    int32_t leftStart, rightStart; // encoder positions at the start
+    uint8_t leftDone, rightDone; // 1 once that wheel has got there
+    uint32_t deadline; // timebase tick to give up at
+    struct MotionProfile profile; // the speed both wheels follow
+};
+
+void Motor_Init(void);
+void Motor_SetDuty(int16_t left, int16_t right);
+void Motor_SetVelocity(int16_t left, int16_t right);
+void Motor_VelocityUpdate(void);
+void Motor_GetDuty(int16_t *left, int16_t *right);
+void Motor_GetVelocity(int16_t *left, int16_t *right);
+uint8_t Motor_Halt(void);
+void Motor_Release(void);
+uint8_t Motor_Halted(void);
 void Motor_StopSimple(void);
 void Motor_ForwardSimple(uint16_t duty, uint32_t time);
 void Motor_BackwardSimple(uint16_t duty, uint32_t time);
 void Motor_LeftSimple(uint16_t duty, uint32_t time);
 void Motor_RightSimple(uint16_t duty, uint32_t time);
-void Motor_SpinRight90();
-void Motor_SpinLeft90();
-void Motor_Spin180();
+void Motor_MoveStart(struct MotorMove *move, int8_t leftSign, int8_t rightSign, int16_t speed, int32_t um, uint32_t timeout);
+enum MotorMoveResult Motor_MoveStep(struct MotorMove *move, uint16_t ms, int16_t *left, int16_t *right);
+uint8_t Motor_Spin(int16_t degrees);
+
+#endif
@@ -0,0 +1,42 @@
+
+#include "msp.h"
+#include "OnBoardLEDs.h"
+
+// Initializes the LaunchPad's red LED (P1.0) and RGB LED (P2.0 to P2.2), all off.
+void OnBoardLEDs_Init(void)
+{
+    P1->SEL0 &= ~0x01;
+    P1->SEL1 &= ~0x01; // GPIO
+    P1->DIR |= 0x01; // output
+    P1->OUT &= ~0x01; // off
+
+    P2->SEL0 &= ~0x07;
+    P2->SEL1 &= ~0x07; // GPIO
+    P2->DIR |= 0x07; // outputs
+    P2->OUT &= ~0x07; // off
+}
+
+// Sets the RGB LED to one of the LED_ colors.
+void OnBoardLEDs_SetColor(uint8_t color)
+{
+    P2->OUT = (P2->OUT & ~0x07) | (color & 0x07);
+}
+
+// Toggles the red LED.
+void OnBoardLEDs_ToggleRed(void)
+{
+    P1->OUT ^= 0x01;
+}
+
+// Turns the red LED on (1) or off (0).
+void OnBoardLEDs_SetRed(uint8_t on)
+{
+    if (on)
+    {
+        P1->OUT |= 0x01;
+    }
+    else
+    {
+        P1->OUT &= ~0x01;
+    }
+}
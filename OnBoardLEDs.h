@@ -0,0 +1,14 @@
+// Colors for the RGB LED (P2.2 = blue, P2.1 = green, P2.0 = red).
+#define LED_OFF 0x00
+#define LED_RED 0x01
+#define LED_GREEN 0x02
+#define LED_YELLOW 0x03
+#define LED_BLUE 0x04
+#define LED_PINK 0x05
+#define LED_SKYBLUE 0x06
+#define LED_WHITE 0x07
+
+void OnBoardLEDs_Init(void);
+void OnBoardLEDs_SetColor(uint8_t color);
+void OnBoardLEDs_ToggleRed(void);
+void OnBoardLEDs_SetRed(uint8_t on);
@@ -0,0 +1,57 @@
+
+#include "msp.h"
+#include "PID.h"
+#include "RamFunc.h"
+
+#define INTEGRAL_LIMIT 100000 // clamp on the summed error so the integral term can't wind up while the robot is stuck
+
+// The gains and speed limit used by PID_Step. Can be changed at run time.
+struct PID_Params pidParams =
+{
+    .kp = 80,
+    .ki = 0,
+    .kd = 520,
+    .maxSpeed = 600
+};
+
+static int32_t integral; // sum of the error over all control ticks since the last reset
+static int16_t lastError; // the error from the previous control tick
+
+// Limits value to the range -limit to limit.
+RAMFUNC static int32_t Clamp(int32_t value, int32_t limit)
+{
+    if (value > limit)
+    {
+        return limit;
+    }
+    if (value < -limit)
+    {
+        return -limit;
+    }
+    return value;
+}
+
+// Clears the controller's memory. Call this before following a line after doing something else.
+void PID_Reset(void)
+{
+    integral = 0;
+    lastError = 0;
+}
+
+// Runs one control tick. Call this once per line sensor sample so the derivative and integral see a fixed rate.
+// error: Input. Line position from -3500 (line is to the left) to +3500 (line is to the right).
+// speed: Input. Forward speed in mm/s to steer around (the cruise profile ramping toward the run's speed).
+// left, right: Outputs. Speed for each wheel in mm/s (-maxSpeed to maxSpeed), ready for Motor_SetVelocity.
+RAMFUNC void PID_Step(int16_t error, int16_t speed, int16_t *left, int16_t *right)
+{
+    integral = Clamp(integral + error, INTEGRAL_LIMIT);
+
+    int32_t correction = ((int32_t)pidParams.kp * error
+            + (int32_t)pidParams.ki * (integral / 100)
+            + (int32_t)pidParams.kd * (error - lastError)) / 1000;
+    lastError = error;
+
+    // A line to the right means the left wheel has to go faster to steer toward it.
+    *left = Clamp(speed + correction, pidParams.maxSpeed);
+    *right = Clamp(speed - correction, pidParams.maxSpeed);
+}
@@ -0,0 +1,20 @@
+#ifndef PID_H
+#define PID_H
+
+// Tunable settings for the line-following controller.
+// kp and kd are scaled by 1/1000, so kp = 100 turns an error of 3500 into a speed correction of 350 mm/s.
+// ki is scaled by 1/100000 and multiplies the error summed over every control tick.
+struct PID_Params
+{
+    int16_t kp; // proportional gain
+    int16_t ki; // integral gain
+    int16_t kd; // derivative gain (per control tick)
+    int16_t maxSpeed; // largest speed (forward or backward) asked of either wheel, in mm/s
+};
+
+extern struct PID_Params pidParams;
+
+void PID_Reset(void);
+void PID_Step(int16_t error, int16_t speed, int16_t *left, int16_t *right);
+
+#endif
@@ -0,0 +1,63 @@
+
+#include "msp.h"
+#include "Probe.h"
+#include "RamFunc.h"
+
+// Names of the probes, in the same order as enum ProbeId.
+const char *const probeNames[NUM_PROBES] =
+{
+    "SysTick",
+    "sensor ISR",
+    "timer ISR",
+    "button ISR",
+    "bumper ISR",
+    "control loop",
+    "speed loop"
+};
+
+// Statistics for each probe. Each probe is only recorded from one context, so no locking is needed.
+static struct ProbeStats probes[NUM_PROBES];
+
+// Starts the DWT cycle counter and clears all statistics.
+void Probe_Init(void)
+{
+    CoreDebug->DEMCR |= 0x01000000; // TRCENA: enable the DWT
+    DWT->CYCCNT = 0; // reset the cycle counter
+    DWT->CTRL |= 0x00000001; // CYCCNTENA: start counting cycles
+    Probe_Reset();
+}
+
+// Clears all statistics.
+void Probe_Reset(void)
+{
+    int i;
+    for (i = 0; i < NUM_PROBES; i++)
+    {
+        probes[i].count = 0;
+        probes[i].min = 0xFFFFFFFF;
+        probes[i].max = 0;
+        probes[i].total = 0;
+    }
+}
+
+// Adds one measurement of "cycles" to probe "id". Called by PROBE_END.
+RAMFUNC void Probe_Record(enum ProbeId id, uint32_t cycles)
+{
+    struct ProbeStats *p = &probes[id];
+    p->count++;
+    p->total += cycles;
+    if (cycles < p->min)
+    {
+        p->min = cycles;
+    }
+    if (cycles > p->max)
+    {
+        p->max = cycles;
+    }
+}
+
+// Copies the statistics of probe "id" into "stats".
+void Probe_Get(enum ProbeId id, struct ProbeStats *stats)
+{
+    *stats = probes[id];
+}
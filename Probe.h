@@ -0,0 +1,46 @@
+#ifndef PROBE_H
+#define PROBE_H
+
+// Comment this out to compile every probe away.
+#define PROBE_ENABLE
+
+// The named probes. Add new ones before NUM_PROBES and give them a name in Probe.c.
+enum ProbeId
+{
+    PROBE_SYSTICK, // SysTick_Handler
+    PROBE_SENSOR_ISR, // TA2_0_IRQHandler and DMA_INT2_IRQHandler (line sensor read), which don't preempt each other
+    PROBE_TIMER_ISR, // TA1_0_IRQHandler (software timers)
+    PROBE_BUTTON_ISR, // PORT1_IRQHandler
+    PROBE_BUMPER_ISR, // PORT4_IRQHandler
+    PROBE_CONTROL, // one pass of the line-following control loop in main
+    PROBE_SPEED, // one pass of the wheel speed loop (Task_Speed)
+    NUM_PROBES
+};
+
+// Cycle counts collected by one probe.
+struct ProbeStats
+{
+    uint32_t count; // number of times the probe ran
+    uint32_t min; // fewest cycles
+    uint32_t max; // most cycles
+    uint64_t total; // sum of all cycles; total / count is the mean
+};
+
+#ifdef PROBE_ENABLE
+// Marks the start of the code being measured. Must be in the same block as the matching PROBE_END.
+#define PROBE_BEGIN(id) uint32_t probeStart_##id = DWT->CYCCNT
+// Marks the end of the code being measured and records the cycles since PROBE_BEGIN.
+#define PROBE_END(id) Probe_Record(id, DWT->CYCCNT - probeStart_##id)
+#else
+#define PROBE_BEGIN(id)
+#define PROBE_END(id)
+#endif
+
+extern const char *const probeNames[NUM_PROBES];
+
+void Probe_Init(void);
+void Probe_Reset(void);
+void Probe_Record(enum ProbeId id, uint32_t cycles);
+void Probe_Get(enum ProbeId id, struct ProbeStats *stats);
+
+#endif
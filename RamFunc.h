@@ -0,0 +1,28 @@
+#ifndef RAMFUNC_H
+#define RAMFUNC_H
+
+// Comment this out to run everything from flash, to compare the timing probes both ways.
+#define RAMFUNC_ENABLE
+
+// Put RAMFUNC in front of a function's definition to run it from SRAM instead of flash. At 48MHz the
+// flash needs 2 wait states (see Clock_Init48MHz), so code run from it stalls on every fetch the
+// prefetch doesn't cover, more so after a branch; SRAM has no wait states, so a function there takes
+// the same cycles every time. Keep it for the interrupt handlers and the control step, and whatever
+// they call, since a call from SRAM back into flash pays the wait states again.
+//
+// In SRAM: the SysTick, line sensor, encoder, bumper and Timer A1 handlers; the speed and control
+// tasks; and everything they call on every pass, down to the probes, the rings and the critical
+// sections. Still in flash: what runs once per junction or per turn (Maze, Turn, and the motion
+// queue steps Timer A1 calls back while a turn is under way), the button, telemetry DMA and RTC
+// handlers, and the main loop's housekeeping.
+//
+// The TI compiler puts these functions in .TI.ramfunc. msp432p401r.cmd loads that section into MAIN
+// and links it to run from SRAM_CODE, with a BINIT copy table that the boot code (_c_int00) copies
+// into SRAM before main is called. Other compilers, such as the simulator's, ignore it.
+#if defined(RAMFUNC_ENABLE) && defined(__TI_COMPILER_VERSION__)
+#define RAMFUNC __attribute__((ramfunc))
+#else
+#define RAMFUNC
+#endif
+
+#endif
@@ -0,0 +1,77 @@
+#ifndef RING_H
+#define RING_H
+
+// A ring buffer for handing items from one interrupt handler (the producer) to the main loop
+// (the consumer), or the other way round, without turning interrupts off. The ring only keeps
+// indexes; the items live in an array of the owner's, with as many entries as the ring's capacity,
+// which must be a power of two. The producer fills the slot Ring_Reserve gives it and then calls
+// Ring_Publish; the consumer reads the slot Ring_Front gives it and then calls Ring_Pop.
+//
+// head is only written by the producer and tail only by the consumer, and both are 16-bit, so each
+// side reads the other's index in one access. The barriers make sure a slot is filled before head
+// says so, and read before tail gives it back.
+//
+// The functions are RAMFUNC, as the handlers that use them are: without optimization they are not
+// inlined, and a copy in flash would pay the wait states the handlers are in SRAM to avoid. Include
+// msp.h and RamFunc.h first.
+//
+//     static struct Sample items[8];
+//     static struct Ring ring = RING_INIT(8);
+//     producer:  int16_t slot = Ring_Reserve(&ring); if (slot >= 0) { items[slot] = s; Ring_Publish(&ring); }
+//     consumer:  int16_t slot = Ring_Front(&ring); if (slot >= 0) { s = items[slot]; Ring_Pop(&ring); }
+struct Ring
+{
+    volatile uint16_t head; // items published since the start; wraps
+    volatile uint16_t tail; // items popped since the start; wraps
+    volatile uint16_t overruns; // items the producer dropped because the ring was full
+    uint16_t mask; // capacity - 1
+};
+
+#define RING_INIT(capacity) { 0, 0, 0, (capacity) - 1 }
+
+// Producer: returns the slot to fill next, or -1 (and counts an overrun) if the ring is full.
+RAMFUNC static inline int16_t Ring_Reserve(struct Ring *r)
+{
+    uint16_t head = r->head;
+    if ((uint16_t)(head - r->tail) > r->mask)
+    {
+        r->overruns++;
+        return -1;
+    }
+    __DMB(); // the consumer was done with the slot before it moved tail past it
+    return head & r->mask;
+}
+
+// Producer: hands the slot from Ring_Reserve to the consumer.
+RAMFUNC static inline void Ring_Publish(struct Ring *r)
+{
+    __DMB(); // the slot is written before head counts it
+    r->head = r->head + 1;
+}
+
+// Consumer: returns the slot of the oldest item, or -1 if the ring is empty.
+RAMFUNC static inline int16_t Ring_Front(struct Ring *r)
+{
+    uint16_t tail = r->tail;
+    if (r->head == tail)
+    {
+        return -1;
+    }
+    __DMB(); // head was read before the slot it counts
+    return tail & r->mask;
+}
+
+// Consumer: gives the slot from Ring_Front back to the producer.
+RAMFUNC static inline void Ring_Pop(struct Ring *r)
+{
+    __DMB(); // the slot is read before the producer can reuse it
+    r->tail = r->tail + 1;
+}
+
+// Returns the number of items waiting.
+RAMFUNC static inline uint16_t Ring_Count(const struct Ring *r)
+{
+    return (uint16_t)(r->head - r->tail);
+}
+
+#endif
@@ -0,0 +1,120 @@
+
+#include "msp.h"
+#include "Scheduler.h"
+#include "Timebase.h"
+#include "RamFunc.h"
+
+static struct Task *tasks; // the task table, in priority order (first = highest)
+static uint8_t numTasks;
+
+// Uses "table" as the task table. Tasks earlier in the table run first when several are ready.
+void Scheduler_Init(struct Task *table, uint8_t count)
+{
+    tasks = table;
+    numTasks = count;
+    Scheduler_Start();
+}
+
+// Restarts every task's period from now, as if the robot was just switched on. Statistics are kept.
+void Scheduler_Start(void)
+{
+    int i;
+    for (i = 0; i < numTasks; i++)
+    {
+        tasks[i].ready = 0;
+        tasks[i].countdown = tasks[i].offset + 1;
+    }
+}
+
+// Releases every task whose period is up. Called from SysTick_Handler with the ticks (ms) since its last call:
+// one, or more when SysTick was stretched over ticks that release nothing (see Scheduler_NextRelease).
+RAMFUNC void Scheduler_Tick(uint16_t ticks)
+{
+    int i;
+    for (i = 0; i < numTasks; i++)
+    {
+        struct Task *t = &tasks[i];
+        uint16_t left = ticks;
+        while (left >= t->countdown) // more than one period can pass if the tick overshot
+        {
+            left -= t->countdown;
+            t->countdown = t->period;
+            if (t->ready) // the last release never got to run
+            {
+                t->misses++;
+            }
+            else
+            {
+                t->releaseTime = Timebase_Now();
+                t->ready = 1;
+            }
+        }
+        t->countdown -= left;
+    }
+}
+
+// Returns the ticks from "after" ticks from now until the first task release after that, so SysTick can
+// skip the ticks in between. Scheduler_NextRelease(0) is the ticks to the next release (1 = the next tick).
+RAMFUNC uint16_t Scheduler_NextRelease(uint16_t after)
+{
+    uint32_t next = 0xFFFF;
+    int i;
+    for (i = 0; i < numTasks; i++)
+    {
+        uint32_t release = tasks[i].countdown;
+        while (release <= after)
+        {
+            release += tasks[i].period;
+        }
+        if (release - after < next)
+        {
+            next = release - after;
+        }
+    }
+    return next;
+}
+
+// Returns 1 if a task has been released and is waiting to run.
+uint8_t Scheduler_Ready(void)
+{
+    int i;
+    for (i = 0; i < numTasks; i++)
+    {
+        if (tasks[i].ready)
+        {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// Runs the highest-priority ready task, if any, from main.
+// Returns 1 if a task ran, 0 if nothing was ready (so the caller can sleep).
+uint8_t Scheduler_Run(void)
+{
+    int i;
+    for (i = 0; i < numTasks; i++)
+    {
+        struct Task *t = &tasks[i];
+        if (t->ready)
+        {
+            uint32_t latency = (Timebase_Now() - t->releaseTime) / TIMEBASE_TICKS_PER_US;
+            if (latency > t->maxLatency)
+            {
+                t->maxLatency = latency;
+            }
+            t->ready = 0;
+            t->run();
+            t->runs++;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// Returns the task table (for reading the statistics) and stores its length in "count".
+const struct Task *Scheduler_Tasks(uint8_t *count)
+{
+    *count = numTasks;
+    return tasks;
+}
@@ -0,0 +1,28 @@
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+// One entry in the task table. Fill in name, run, period and offset; the scheduler owns the rest.
+struct Task
+{
+    const char *name;
+    void (*run)(void); // runs to completion in main, never in an interrupt
+    uint16_t period; // ticks (ms) between releases
+    uint16_t offset; // ticks after Scheduler_Start before the first release, to stagger tasks
+
+    volatile uint16_t countdown; // ticks until the next release
+    volatile uint8_t ready; // released but not started yet
+    volatile uint32_t releaseTime; // timebase tick of the latest release
+    uint32_t runs; // number of times the task has run
+    volatile uint32_t misses; // releases that came while the previous one still hadn't started
+    uint32_t maxLatency; // longest time from release to start, in us (the task's jitter)
+};
+
+void Scheduler_Init(struct Task *table, uint8_t count);
+void Scheduler_Start(void);
+void Scheduler_Tick(uint16_t ticks);
+uint16_t Scheduler_NextRelease(uint16_t after);
+uint8_t Scheduler_Ready(void);
+uint8_t Scheduler_Run(void);
+const struct Task *Scheduler_Tasks(uint8_t *count);
+
+#endif
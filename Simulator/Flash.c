@@ -0,0 +1,125 @@
+/* Flash.c (Simulator)
+ * Host stand-in for Flash.c: the store sectors are an array in RAM that
+ * behaves like flash (erasing sets every bit, programming can only clear
+ * bits). If SIM_FLASH names a file, the array is loaded from it on first
+ * use and saved back after every change, so a later run of the simulator
+ * boots with what an earlier one stored, like the robot after a power
+ * cycle. The host tests can also cut the power part-way through a
+ * write with Flash_FailAfter.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "msp.h"
+#include "Flash.h"
+#include "Simulator.h"
+
+static uint32_t flash[FLASH_SECTORS][FLASH_SECTOR_WORDS];
+static int loaded; // whether the array has been set up
+static int restored; // whether it came from an earlier run's file
+static int powerLeft = -1; // erases and programs that still complete before the power fails, or -1 for no failure
+static int powerOff; // whether the power has failed
+
+// Sets the array up as erased flash, or from the SIM_FLASH file if it exists.
+static void Load(void)
+{
+    const char *path = getenv("SIM_FLASH");
+    FILE *f;
+    unsigned i, j;
+    if (loaded)
+    {
+        return;
+    }
+    loaded = 1;
+    for (i = 0; i < FLASH_SECTORS; i++)
+    {
+        for (j = 0; j < FLASH_SECTOR_WORDS; j++)
+        {
+            flash[i][j] = FLASH_ERASED;
+        }
+    }
+    if (path && (f = fopen(path, "rb")))
+    {
+        restored = fread(flash, sizeof(flash), 1, f) == 1;
+        fclose(f);
+    }
+}
+
+// Writes the array to the SIM_FLASH file, if there is one.
+static void Save(void)
+{
+    const char *path = getenv("SIM_FLASH");
+    FILE *f;
+    if (path && (f = fopen(path, "wb")))
+    {
+        fwrite(flash, sizeof(flash), 1, f);
+        fclose(f);
+    }
+}
+
+// Returns 1 if the flash was loaded from an earlier run.
+int Flash_Restored(void)
+{
+    Load();
+    return restored;
+}
+
+// Lets "operations" more erases and programs complete, then fails the power part-way through the next
+// one and drops the rest, until it is called again. -1 restores the power for good.
+void Flash_FailAfter(int operations)
+{
+    powerLeft = operations;
+    powerOff = 0;
+}
+
+// Returns how much of the next erase or program gets done: 2 all of it, 1 half of it (the power
+// fails during it), 0 none of it.
+static int Power(void)
+{
+    if (powerLeft < 0)
+    {
+        return 2;
+    }
+    if (powerLeft > 0)
+    {
+        powerLeft--;
+        return 2;
+    }
+    if (powerOff)
+    {
+        return 0;
+    }
+    powerOff = 1;
+    return 1;
+}
+
+const uint32_t *Flash_Sector(uint8_t sector)
+{
+    Load();
+    return flash[sector];
+}
+
+uint8_t Flash_Erase(uint8_t sector)
+{
+    unsigned i, words = FLASH_SECTOR_WORDS * Power() / 2; // a cut-short erase gets through half the sector
+    Load();
+    for (i = 0; i < words; i++)
+    {
+        flash[sector][i] = FLASH_ERASED;
+    }
+    Save();
+    return words == FLASH_SECTOR_WORDS;
+}
+
+uint8_t Flash_Program(uint8_t sector, uint16_t index, uint32_t word)
+{
+    int power = Power();
+    Load();
+    if (power == 0)
+    {
+        return 0;
+    }
+    flash[sector][index] &= (power == 2) ? word : word | 0xFFFF0000; // a cut-short program only clears the low half
+    Save();
+    return flash[sector][index] == word;
+}
@@ -0,0 +1,991 @@
+/* Simulator.c
+ * Runs the line follower firmware on Linux against a model of the RSLK
+ * chassis and a bitmap track, faster than real time.
+ *
+ * The firmware sources are compiled unchanged against Simulator/msp.h,
+ * whose registers are plain structs. Simulated time only moves when the
+ * firmware waits (WaitForInterrupt, or polling Timer32 for a delay), one
+ * microsecond per step. Each step advances Timer_A and SysTick, models the
+ * QTR sensor discharge on P7 and the DMA channel that samples it, and
+ * the UART and DMA channel the telemetry goes out on, and calls any interrupt handler that is pending and enabled. Every millisecond the robot's wheels and pose are
+ * integrated from the PWM duty in TIMER_A0 and the direction/sleep pins. A WFI with SLEEPDEEP set
+ * is LPM3: Timer_A, SysTick, Timer32 and the UART stand still until an interrupt, and only the RTC
+ * and the ports carry on.
+ *
+ * Build and run with Simulator/build.sh:
+ *     Simulator/build.sh && ./sim 60
+ *     ./sim 60 mytrack.pgm 500 200 90   (seconds, track, start x y heading)
+ *
+ * When the robot reaches the goal of a maze (the firmware's state becomes
+ * WIN), it is put back where it started and the right button is pressed,
+ * so the second run replays the solution the first one found. With
+ *     SIM_FLASH=flash.bin ./sim ...
+ * the firmware's flash store is kept in flash.bin, and a later run that
+ * finds the solution already stored presses the right button at once.
+ * SIM_TELEMETRY=telemetry.bin saves the bytes sent on the UART, for
+ * Tools/TelemetryDecode. SIM_BUMP=2.5 presses the middle bump switches
+ * 2.5 s after the start button, as if the robot hit a wall, and reports
+ * how long the motors took to go off and how far the robot coasted.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "msp.h"
+#include "Simulator.h"
+#include "Probe.h"
+#include "Scheduler.h"
+
+// The registers the firmware sees.
+DIO_PORT_Type Sim_Port[12];
+Timer_A_Type Sim_TimerA[4];
+SysTick_Type Sim_SysTick;
+NVIC_Type Sim_NVIC;
+SCB_Type Sim_SCB;
+WDT_A_Type Sim_WDT_A;
+CoreDebug_Type Sim_CoreDebug;
+PCM_Type Sim_PCM;
+CS_Type Sim_CS;
+FLCTL_Type Sim_FLCTL;
+EUSCI_A_Type Sim_EUSCI_A0;
+DMA_Control_Type Sim_DMA_Control;
+DMA_Channel_Type Sim_DMA_Channel;
+RTC_C_Type Sim_RTC_C;
+static DWT_Type dwt;
+static Timer32_Type timer32;
+static uint64_t timer32Start; // when Timer32_1 was last written while enabled
+
+uint64_t Sim_Now; // simulated time since reset, in us
+
+// Chassis model
+#define WHEEL_BASE 140.0 // distance between the wheels, in mm
+#define MAX_SPEED 800.0 // wheel speed at 100% duty, in mm/s
+#define DEADBAND 800 // duty below which the wheels don't turn
+#define MOTOR_TAU 0.05 // motor time constant, in s
+#define SENSOR_AHEAD 70.0 // distance from the axle to the sensor bar, in mm
+#define SENSOR_PITCH 9.525 // distance between sensors, in mm
+#define WHITE_US 200 // discharge time over white
+#define ENCODER_MM (70.0 * M_PI / 360) // wheel travel per encoder edge: 70mm wheel, 360 edges per turn
+#define BLACK_US 2000 // discharge time over the middle of the line
+#define BUMP_SWITCHES 0x28 // P4.3 and P4.5, the two middle bump switches
+#define BUMP_HOLD 50000 // how long the switches stay pressed, in us
+
+// Run control
+#define BUTTON_TIME 100000 // when the left button is pressed to start the run, in us
+#define LAP_AWAY 300.0 // the robot must get this far from the start before a lap can count, in mm
+#define LAP_NEAR 40.0 // and then come back this close, in mm
+#define REPLAY_DELAY 1000000 // time on the goal before the robot is carried back for the solution run, in us
+#define WIN 2 // the firmware's enum State values (Globals.c)
+#define SOLUTIONING 3
+
+// Firmware entry points. main.c is compiled with main renamed to Firmware_Main.
+void Firmware_Main(void);
+void SysTick_Handler(void) __attribute__((weak));
+void TA0_0_IRQHandler(void) __attribute__((weak));
+void TA1_0_IRQHandler(void) __attribute__((weak));
+void TA2_0_IRQHandler(void) __attribute__((weak));
+void TA3_0_IRQHandler(void) __attribute__((weak));
+void TA3_N_IRQHandler(void) __attribute__((weak));
+void Encoder_Read(int32_t *left, int32_t *right) __attribute__((weak));
+void PORT1_IRQHandler(void) __attribute__((weak));
+void PORT4_IRQHandler(void) __attribute__((weak));
+void DMA_INT1_IRQHandler(void) __attribute__((weak));
+void DMA_INT2_IRQHandler(void) __attribute__((weak));
+void RTC_C_IRQHandler(void) __attribute__((weak));
+uint16_t LineSensor_Overruns(void) __attribute__((weak));
+uint16_t Encoder_Overruns(void) __attribute__((weak));
+uint16_t OnBoardButtons_Overruns(void) __attribute__((weak));
+uint16_t Telemetry_Overruns(void) __attribute__((weak));
+uint32_t Bumpers_HaltCycles(void) __attribute__((weak));
+struct IdleStats;
+void Idle_GetStats(struct IdleStats *stats) __attribute__((weak));
+extern volatile int state; // enum State in Globals.c, which can't be included here
+
+// An interrupt source the simulator can deliver.
+struct Source
+{
+    const char *name;
+    int irq; // NVIC interrupt number, or -1 for SysTick
+    void (*handler)(void);
+    uint32_t calls; // number of times the handler was called
+};
+
+static struct Source sources[] =
+{
+    { "SysTick", -1, 0, 0 },
+    { "TA0_0", 8, 0, 0 },
+    { "TA1_0", 10, 0, 0 },
+    { "TA2_0", 12, 0, 0 },
+    { "TA3_0", 14, 0, 0 },
+    { "TA3_N", 15, 0, 0 },
+    { "PORT1", 35, 0, 0 },
+    { "DMA_INT1", 33, 0, 0 },
+    { "PORT4", 38, 0, 0 },
+    { "RTC_C", 29, 0, 0 },
+    { "DMA_INT2", 32, 0, 0 },
+};
+#define NUM_SOURCES (sizeof(sources) / sizeof(sources[0]))
+
+static int interruptsEnabled = 1; // PRIMASK clear out of reset
+static int inInterrupt; // handlers don't nest in the simulator
+static uint32_t interruptCalls; // total handler calls, used to wake WaitForInterrupt
+static int sysTickPending;
+static int deepSleep; // 1 while the firmware is in LPM3
+static uint64_t deepUs; // time spent in LPM3
+static uint32_t timerAccumulator[4]; // SMCLK counts not yet applied to each Timer_A
+
+// A uDMA channel control structure, laid out as the firmware's.
+struct DmaDescriptor
+{
+    volatile void *srcEnd, *dstEnd;
+    volatile uint32_t control, spare;
+};
+static uint32_t dmaEnabled; // channels enabled; ENASET is write-one-to-set on the device
+static uint8_t dmaRequests; // channels a timer triggered in the current step
+static uint64_t uartFree; // when the UART can take its next byte
+static FILE *telemetry; // where the bytes the UART sends go, if anywhere
+
+static uint8_t lastP7Dir; // to see when the firmware releases P7
+static uint64_t dischargeStart; // when P7 was last released
+static uint16_t dischargeTime[8]; // discharge time of each sensor for the current read
+static int charged; // whether P7 has been charged since reset
+
+static struct
+{
+    double x, y, heading; // mm, mm, radians (counterclockwise from +x)
+    double vLeft, vRight; // wheel speeds, in mm/s
+    double left, right; // wheel travel since reset, in encoder edges
+} robot;
+
+// Statistics for the report
+static uint64_t endTime;
+static double startX, startY, startHeading;
+static int away; // whether the robot has left the start area since the last lap
+static uint64_t lapStart;
+static int laps;
+static uint64_t bestLap;
+static int offTrack; // whether no sensor currently sees the line
+static int offTrackEvents;
+static uint64_t offTrackUs;
+static double distance;
+static uint64_t sleepUs; // time spent in WaitForInterrupt
+static uint64_t pollUs; // time spent reading the timebase outside interrupts (busy-waiting)
+static int replaying; // whether the current maze run is a replay of the solution
+static uint64_t runStart; // when the current maze run started
+static uint64_t runTimes[2]; // time to the goal exploring, then replaying
+static uint64_t winTime; // when the robot reached the goal
+static uint64_t bumpTime; // when the bump switches are pressed, or 0 for never
+static uint64_t bumpOff; // when both motors were off after the bump
+static uint64_t bumpStill; // when the wheels had stopped turning after the bump
+static double bumpDistance; // distance driven when the switches were pressed, and then how far the robot coasted
+
+// Lets 1us pass and returns the Timer32_1 registers with VALUE brought up to date.
+// Only free-running mode with prescale /16 (3 counts per us) is modeled.
+Timer32_Type *Sim_Timer32(void)
+{
+    static uint32_t lastControl;
+    if (!inInterrupt) // time spent polling in main is main blocked
+    {
+        pollUs++;
+    }
+    Sim_Advance(1);
+    if ((timer32.CONTROL & 0x80) && !(lastControl & 0x80)) // just enabled
+    {
+        timer32Start = Sim_Now;
+    }
+    lastControl = timer32.CONTROL;
+    if (timer32.CONTROL & 0x80)
+    {
+        timer32.VALUE = timer32.LOAD - (uint32_t)((Sim_Now - timer32Start) * 3);
+    }
+    return &timer32;
+}
+
+// Returns the DWT registers with CYCCNT brought up to date with the host clock.
+DWT_Type *Sim_DWT(void)
+{
+    static uint64_t last; // host time of the previous update, in ns
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    uint64_t now = ts.tv_sec * 1000000000ull + ts.tv_nsec;
+    if (dwt.CTRL & 0x1)
+    {
+        dwt.CYCCNT += (uint32_t)(now * 48 / 1000 - last * 48 / 1000);
+    }
+    last = now;
+    return &dwt;
+}
+
+// Returns the priority of a source (lower runs first).
+static int Sim_Priority(const struct Source *s)
+{
+    if (s->irq < 0)
+    {
+        return SCB->SHP[11] >> 5;
+    }
+    return NVIC->IP[s->irq] >> 5;
+}
+
+// Returns whether a source is asking for an interrupt.
+// NVIC->ISER isn't checked: on the device it is write-one-to-set, so firmware assigns to it freely,
+// which a plain struct can't model. The peripheral's own enable bits decide instead.
+static int Sim_Pending(const struct Source *s)
+{
+    if (!s->handler)
+    {
+        return 0;
+    }
+    if (s->irq < 0)
+    {
+        return sysTickPending;
+    }
+    if (NVIC->ISPR[s->irq >> 5] & (1u << (s->irq & 31))) // set pending by the firmware
+    {
+        return 1;
+    }
+    if ((s->irq == 32) || (s->irq == 33)) // DMA_INT2 and DMA_INT1, for the channel in INT2_SRCCFG or INT1_SRCCFG
+    {
+        DMA_Channel->INT0_SRCFLG &= ~DMA_Channel->INT0_CLRFLG; // the clear register is write-one-to-clear
+        DMA_Channel->INT0_CLRFLG = 0;
+        uint32_t source = (s->irq == 33) ? DMA_Channel->INT1_SRCCFG : DMA_Channel->INT2_SRCCFG;
+        return (source & 0x20) && (DMA_Channel->INT0_SRCFLG & (1u << (source & 0x1F)));
+    }
+    if ((s->irq >= 8) && (s->irq <= 15))
+    {
+        Timer_A_Type *t = &Sim_TimerA[(s->irq - 8) / 2];
+        if (!(s->irq & 1)) // TAx_0 is CCR0's flag and enable
+        {
+            return (t->CCTL[0] & 0x0011) == 0x0011;
+        }
+        int i; // TAx_N is CCR1 to CCR6 and the overflow
+        for (i = 1; i < 7; i++)
+        {
+            if ((t->CCTL[i] & 0x0011) == 0x0011)
+            {
+                return 1;
+            }
+        }
+        return (t->CTL & 0x0003) == 0x0003;
+    }
+    if (s->irq == 29) // RTC_C: only the RT1PS interval interrupt
+    {
+        return (RTC_C->PS1CTL & 0x0003) == 0x0003;
+    }
+    if (s->irq >= 35) // PORTx
+    {
+        DIO_PORT_Type *p = &Sim_Port[s->irq - 34];
+        return (p->IFG & p->IE) != 0;
+    }
+    return 0;
+}
+
+// Stops the simulation if the firmware pends an interrupt that no simulated source handles.
+// On the device that interrupt would run Default_Handler, which never returns.
+static void Sim_CheckPending(void)
+{
+    int word;
+    for (word = 0; word < 2; word++)
+    {
+        uint32_t unknown = NVIC->ISPR[word];
+        unsigned i;
+        for (i = 0; i < NUM_SOURCES; i++)
+        {
+            if ((sources[i].irq >> 5) == word)
+            {
+                unknown &= ~(1u << (sources[i].irq & 31));
+            }
+        }
+        if (unknown)
+        {
+            int bit = 0;
+            while (!(unknown & (1u << bit)))
+            {
+                bit++;
+            }
+            fprintf(stderr, "interrupt %d pended with no handler: Default_Handler would hang the robot\n", word * 32 + bit);
+            exit(1);
+        }
+    }
+}
+
+// Adds the channels the firmware has enabled by writing ENASET to dmaEnabled, and shows them all in
+// ENASET again. A plain struct can't be write-one-to-set, so a write that names one channel would
+// otherwise read back as the others being disabled.
+static void Sim_DmaEnable(void)
+{
+    dmaEnabled |= DMA_Control->ENASET;
+    DMA_Control->ENASET = dmaEnabled;
+}
+
+// Moves the next byte of the transfer on DMA channel c, and when that was the last one, disables the
+// channel and flags its interrupt. Only basic mode, a byte at a time, is modeled; each address either
+// steps a byte at a time or doesn't increment.
+static void Sim_DmaMove(int c)
+{
+    struct DmaDescriptor *d = (struct DmaDescriptor *)DMA_Control->CTLBASE + c;
+    int n = ((d->control >> 4) & 0x3FF) + 1; // bytes left
+    volatile uint8_t *src = (volatile uint8_t *)d->srcEnd + (((d->control >> 26) & 0x3) == 3 ? 0 : 1 - n);
+    volatile uint8_t *dst = (volatile uint8_t *)d->dstEnd + (((d->control >> 30) & 0x3) == 3 ? 0 : 1 - n);
+    *dst = *src;
+    if (n == 1)
+    {
+        d->control &= ~0x7;
+        dmaEnabled &= ~(1u << c);
+        DMA_Control->ENASET = dmaEnabled;
+        DMA_Channel->INT0_SRCFLG |= 1u << c;
+    }
+    else
+    {
+        d->control -= 0x10;
+    }
+}
+
+// Moves a byte on each DMA channel a timer triggered this step. Channel 2n with source 6 is triggered
+// by TIMER_An's CCR0. Runs after the sensors are updated, as an interrupt handler reading them would.
+static void Sim_Dma(void)
+{
+    int c;
+    for (c = 0; c < 8; c += 2)
+    {
+        if ((dmaRequests & (1u << c)) && (dmaEnabled & (1u << c)) && (DMA_Control->CFG & 0x01))
+        {
+            Sim_DmaMove(c);
+        }
+    }
+    dmaRequests = 0;
+}
+
+// Calls pending handlers, highest priority first, until none are pending.
+static void Sim_Dispatch(void)
+{
+    Sim_CheckPending();
+    while (interruptsEnabled && !inInterrupt)
+    {
+        struct Source *best = 0;
+        unsigned i;
+        for (i = 0; i < NUM_SOURCES; i++)
+        {
+            if (Sim_Pending(&sources[i]) && (!best || (Sim_Priority(&sources[i]) < Sim_Priority(best))))
+            {
+                best = &sources[i];
+            }
+        }
+        if (!best)
+        {
+            return;
+        }
+        if (best->irq < 0)
+        {
+            sysTickPending = 0; // SysTick acknowledges itself
+        }
+        else
+        {
+            NVIC->ISPR[best->irq >> 5] &= ~(1u << (best->irq & 31)); // taking an interrupt clears its pending bit
+        }
+        inInterrupt = 1;
+        best->handler();
+        inInterrupt = 0;
+        Sim_DmaEnable(); // the handler may have enabled a DMA channel
+        best->calls++;
+        interruptCalls++;
+    }
+}
+
+// Sends the next byte of a DMA transfer from channel 0 to eUSCI_A0, if the UART is free for one.
+// Only basic mode, a byte at a time, with the channel triggered by UCA0TXIFG, is modeled.
+static void Sim_Uart(void)
+{
+    if ((Sim_Now < uartFree) || (EUSCI_A0->CTLW0 & 0x0001) || !(dmaEnabled & 0x01) || (DMA_Channel->CH_SRCCFG[0] != 1))
+    {
+        return;
+    }
+    struct DmaDescriptor *d = (struct DmaDescriptor *)DMA_Control->CTLBASE;
+    if (!d || !(d->control & 0x7))
+    {
+        return;
+    }
+    Sim_DmaMove(0);
+    if (telemetry)
+    {
+        fputc(EUSCI_A0->TXBUF & 0xFF, telemetry);
+    }
+    double clocksPerBit = (EUSCI_A0->MCTLW & 0x0001) ? 16 * EUSCI_A0->BRW + ((EUSCI_A0->MCTLW >> 4) & 0xF) : EUSCI_A0->BRW;
+    uartFree = Sim_Now + (uint64_t)(10 * clocksPerBit / 12 + 0.5); // start, 8 data and stop bits of SMCLK / 12 per us
+}
+
+// Moves one wheel's encoder by 1us at speed v (mm/s). Channel A is wired to capture input "ccr" of
+// Timer A3 and channel B to P5 bit "b". Every whole edge of travel is a rising edge of A, with B high going forward.
+static void Sim_Encoder(double *position, double v, int ccr, uint8_t b)
+{
+    double last = *position;
+    *position += v * 1e-6 / ENCODER_MM;
+    if (floor(*position) == floor(last))
+    {
+        return;
+    }
+    if (v > 0)
+    {
+        P5->IN |= b;
+    }
+    else
+    {
+        P5->IN &= ~b;
+    }
+    Timer_A_Type *t = TIMER_A3;
+    if ((t->CCTL[ccr] & 0x0100) && (t->CCTL[ccr] & 0xC000)) // capture mode, on an edge
+    {
+        if (t->CCTL[ccr] & 0x0001)
+        {
+            t->CCTL[ccr] |= 0x0002; // capture overflow: the previous one wasn't read yet
+        }
+        t->CCR[ccr] = t->R;
+        t->CCTL[ccr] |= 0x0001;
+    }
+}
+
+// Advances Timer_A n by 1us of SMCLK (12MHz). Only timers with an interrupt or a DMA channel on CCR0
+// enabled are counted, since nothing else in the firmware reads TAxR.
+static void Sim_TimerAStep(int n)
+{
+    Timer_A_Type *t = &Sim_TimerA[n];
+    if (t->CTL & 0x0004) // TACLR
+    {
+        t->R = 0;
+        timerAccumulator[n] = 0;
+        t->CTL &= ~0x0004;
+    }
+    uint16_t mode = (t->CTL >> 4) & 0x3;
+    if ((mode == 0) || (((t->CTL >> 8) & 0x3) != 2)) // stopped, or not on SMCLK
+    {
+        return;
+    }
+    int i, watched = t->CTL & 0x0002;
+    int dma = (DMA_Channel->CH_SRCCFG[2 * n] == 6) && (dmaEnabled & (1u << (2 * n))); // channel 2n triggered by CCR0
+    watched |= dma;
+    for (i = 0; i < 7; i++)
+    {
+        watched |= t->CCTL[i] & 0x0010;
+    }
+    if (!watched)
+    {
+        return;
+    }
+    uint32_t divider = (1u << ((t->CTL >> 6) & 0x3)) * ((t->EX0 & 0x7) + 1);
+    timerAccumulator[n] += 12;
+    while (timerAccumulator[n] >= divider)
+    {
+        timerAccumulator[n] -= divider;
+        if ((mode == 1) && (t->R >= t->CCR[0])) // up mode rolls over after CCR0
+        {
+            t->R = 0;
+        }
+        else
+        {
+            t->R++;
+            if ((mode == 2) && (t->R == 0)) // continuous mode overflow
+            {
+                t->CTL |= 0x0001;
+            }
+        }
+        for (i = 0; i < 7; i++)
+        {
+            if (!(t->CCTL[i] & 0x0100) && (t->R == t->CCR[i]) && ((mode != 1) || (t->R != 0) || (i == 0))) // compare match
+            {
+                t->CCTL[i] |= 0x0001;
+                if ((i == 0) && dma)
+                {
+                    dmaRequests |= 1u << (2 * n);
+                }
+            }
+        }
+    }
+}
+
+// Advances SysTick by 1us of MCLK (48MHz).
+static void Sim_SysTickStep(void)
+{
+    if (!(SysTick->CTRL & 0x1))
+    {
+        return;
+    }
+    if (SysTick->VAL == 0) // cleared by a write: it reloads on the next count without wrapping
+    {
+        SysTick->VAL = SysTick->LOAD + 1;
+    }
+    if (SysTick->VAL > 48)
+    {
+        SysTick->VAL -= 48;
+    }
+    else
+    {
+        SysTick->VAL = SysTick->LOAD + 1 - (48 - SysTick->VAL);
+        SysTick->CTRL |= 0x00010000; // COUNTFLAG
+        if (SysTick->CTRL & 0x2)
+        {
+            sysTickPending = 1;
+        }
+    }
+}
+
+// Advances the RTC's prescalers by 1us of BCLK (32768Hz), and flags the RT1PS interval interrupt
+// every 2^(RT1IP + 9) counts.
+static void Sim_RtcStep(void)
+{
+    static uint64_t counts; // BCLK counts since the RTC was released from hold
+    static uint64_t us;
+    if (RTC_C->CTL13 & 0x0040) // RTCHOLD
+    {
+        return;
+    }
+    us++;
+    uint64_t now = us * 32768 / 1000000;
+    if (now == counts)
+    {
+        return;
+    }
+    int shift = ((RTC_C->PS1CTL >> 2) & 0x7) + 9;
+    if ((now >> shift) != (counts >> shift))
+    {
+        RTC_C->PS1CTL |= 0x0001; // RT1PSIFG
+    }
+    counts = now;
+    RTC_C->PS = (uint16_t)counts;
+}
+
+// Returns the world position of sensor i (bit i of P7).
+static void Sim_SensorPosition(int i, double *x, double *y)
+{
+    double right = (3.5 - i) * SENSOR_PITCH; // bit 0 is the right-most sensor
+    *x = robot.x + SENSOR_AHEAD * cos(robot.heading) + right * sin(robot.heading);
+    *y = robot.y + SENSOR_AHEAD * sin(robot.heading) - right * cos(robot.heading);
+}
+
+// Models the QTR-8RC sensors: P7 pins driven high charge the capacitors, and once released
+// each pin reads high until its discharge time, which is longer over the line.
+static void Sim_LineSensors(void)
+{
+    int i;
+    if (P7->DIR == 0xFF)
+    {
+        charged = 1;
+    }
+    else if ((lastP7Dir == 0xFF) && (P7->DIR == 0)) // just released
+    {
+        dischargeStart = Sim_Now;
+        for (i = 0; i < 8; i++)
+        {
+            double x, y;
+            Sim_SensorPosition(i, &x, &y);
+            double dark = (P5->OUT & 0x08) ? Track_Darkness(x, y) : 1; // no IR light reflects with the LED off
+            dischargeTime[i] = WHITE_US + dark * (BLACK_US - WHITE_US);
+        }
+    }
+    lastP7Dir = P7->DIR;
+
+    uint8_t in = P7->OUT & P7->DIR; // driven pins read back what they drive
+    for (i = 0; i < 8; i++)
+    {
+        if (!(P7->DIR & (1 << i)) && charged && (Sim_Now - dischargeStart < dischargeTime[i]))
+        {
+            in |= 1 << i;
+        }
+    }
+    P7->IN = in;
+}
+
+// Returns the duty (0 to 10000, negative for backward) a motor driver is applying.
+// pwm: the P2 bit, sleep: the P3 bit, direction: the P5 bit, ccr: the TIMER_A0 compare register.
+static int Sim_MotorDuty(uint8_t pwm, uint8_t sleep, uint8_t direction, int ccr)
+{
+    int duty;
+    if (!(P3->OUT & sleep)) // driver asleep
+    {
+        return 0;
+    }
+    if (P2->SEL0 & pwm) // pin is TA0.x
+    {
+        duty = (TIMER_A0->CTL & 0x0030) ? TIMER_A0->CCR[ccr] : 0;
+        if (duty > 10000)
+        {
+            duty = 10000;
+        }
+    }
+    else // pin is GPIO
+    {
+        duty = (P2->OUT & pwm) ? 10000 : 0;
+    }
+    return (P5->OUT & direction) ? -duty : duty;
+}
+
+// Returns the steady-state wheel speed for a duty.
+static double Sim_WheelSpeed(int duty)
+{
+    int magnitude = abs(duty);
+    if (magnitude <= DEADBAND)
+    {
+        return 0;
+    }
+    double speed = (magnitude - DEADBAND) * MAX_SPEED / (10000 - DEADBAND);
+    return (duty < 0) ? -speed : speed;
+}
+
+// Integrates the chassis over dt seconds and updates the lap and off-track statistics.
+static void Sim_Robot(double dt)
+{
+    robot.vLeft += (Sim_WheelSpeed(Sim_MotorDuty(0x80, 0x80, 0x10, 4)) - robot.vLeft) * dt / MOTOR_TAU;
+    robot.vRight += (Sim_WheelSpeed(Sim_MotorDuty(0x40, 0x40, 0x20, 3)) - robot.vRight) * dt / MOTOR_TAU;
+    double v = (robot.vLeft + robot.vRight) / 2;
+    robot.x += v * cos(robot.heading) * dt;
+    robot.y += v * sin(robot.heading) * dt;
+    robot.heading += (robot.vRight - robot.vLeft) / WHEEL_BASE * dt;
+    distance += fabs(v) * dt;
+
+    int i, seen = 0;
+    for (i = 0; i < 8; i++)
+    {
+        double x, y;
+        Sim_SensorPosition(i, &x, &y);
+        seen |= Track_Darkness(x, y) > 0.3;
+    }
+    if (Sim_Now > BUTTON_TIME)
+    {
+        if (!seen && !offTrack)
+        {
+            offTrackEvents++;
+        }
+        if (!seen)
+        {
+            offTrackUs += (uint64_t)(dt * 1e6);
+        }
+    }
+    offTrack = !seen;
+
+    double fromStart = hypot(robot.x - startX, robot.y - startY);
+    if (fromStart > LAP_AWAY)
+    {
+        away = 1;
+    }
+    else if (away && (fromStart < LAP_NEAR))
+    {
+        uint64_t lap = Sim_Now - lapStart;
+        laps++;
+        printf("lap %d: %.3f s\n", laps, lap / 1e6);
+        if (!bestLap || (lap < bestLap))
+        {
+            bestLap = lap;
+        }
+        lapStart = Sim_Now;
+        away = 0;
+    }
+}
+
+// Prints the results of the run and exits.
+static void Sim_Report(void)
+{
+    double seconds = (Sim_Now - BUTTON_TIME) / 1e6;
+    unsigned i;
+    printf("simulated time:   %.3f s (from the start button)\n", seconds);
+    printf("laps:             %d\n", laps);
+    if (laps)
+    {
+        printf("best lap:         %.3f s\n", bestLap / 1e6);
+    }
+    printf("distance:         %.0f mm (%.0f mm/s average)\n", distance, distance / seconds);
+    printf("off track:        %d times, %.3f s total\n", offTrackEvents, offTrackUs / 1e6);
+    printf("main sleeping:    %.1f %% (WaitForInterrupt), %.1f %% of it in LPM3\n", 100.0 * sleepUs / Sim_Now, sleepUs ? 100.0 * deepUs / sleepUs : 0);
+    if (Idle_GetStats)
+    {
+        uint32_t idle[5]; // struct IdleStats: active, LPM0 and LPM3 us, then LPM0 and LPM3 sleeps
+        Idle_GetStats((struct IdleStats *)idle);
+        printf("idle (firmware):  active %.3f s, LPM0 %.3f s (%u sleeps), LPM3 %.3f s (%u sleeps)\n",
+               idle[0] / 1e6, idle[1] / 1e6, idle[3], idle[2] / 1e6, idle[4]);
+    }
+    printf("main blocked:     %.1f %% (polling the timebase)\n", 100.0 * pollUs / Sim_Now);
+    for (i = 0; i < NUM_SOURCES; i++)
+    {
+        if (sources[i].calls)
+        {
+            printf("%-8s handler:  %u calls (%.0f/s)\n", sources[i].name, sources[i].calls, sources[i].calls / (Sim_Now / 1e6));
+        }
+    }
+    if (Encoder_Read)
+    {
+        int32_t left, right;
+        Encoder_Read(&left, &right);
+        printf("encoders:         left %.0f mm, right %.0f mm (wheels went %.0f mm, %.0f mm)\n",
+               left * ENCODER_MM, right * ENCODER_MM, robot.left * ENCODER_MM, robot.right * ENCODER_MM);
+    }
+    if (LineSensor_Overruns && Encoder_Overruns && OnBoardButtons_Overruns && Telemetry_Overruns)
+    {
+        printf("queue overruns:   sensor %u, encoder %u, button %u, telemetry %u\n",
+               LineSensor_Overruns(), Encoder_Overruns(), OnBoardButtons_Overruns(), Telemetry_Overruns());
+    }
+    if (bumpTime && (Sim_Now > bumpTime))
+    {
+        printf("bump:             motors off %u us after the switches closed (worst handler time to off, plus nominal entry: %.2f host us)\n",
+               (unsigned)(bumpOff - bumpTime), Bumpers_HaltCycles ? Bumpers_HaltCycles() / 48.0 : 0);
+        if (bumpStill)
+        {
+            printf("                  wheels stopped %.3f s later, after coasting %.0f mm\n", (bumpStill - bumpTime) / 1e6, bumpDistance);
+        }
+    }
+    uint8_t numTasks;
+    const struct Task *tasks = Scheduler_Tasks(&numTasks);
+    printf("task          runs   misses  max latency (us)\n");
+    for (i = 0; i < numTasks; i++)
+    {
+        printf("%-10s %7u %8u %8u\n", tasks[i].name, tasks[i].runs, tasks[i].misses, tasks[i].maxLatency);
+    }
+    printf("probe (host us)   count      min     mean      max\n");
+    for (i = 0; i < NUM_PROBES; i++)
+    {
+        struct ProbeStats p;
+        Probe_Get(i, &p);
+        if (p.count)
+        {
+            printf("%-14s %8u %8.2f %8.2f %8.2f\n", probeNames[i], p.count, p.min / 48.0, (double)p.total / p.count / 48.0, p.max / 48.0);
+        }
+    }
+    exit(0);
+}
+
+// Times the maze runs and, after an exploration, carries the robot back to the start for the solution.
+static void Sim_Maze(void)
+{
+    if (state == SOLUTIONING)
+    {
+        replaying = 1;
+    }
+    if (state != WIN)
+    {
+        winTime = 0;
+        return;
+    }
+    if (!winTime)
+    {
+        winTime = Sim_Now;
+        runTimes[replaying] = Sim_Now - runStart;
+        printf("%s run: %.3f s\n", replaying ? "solution" : "exploration", runTimes[replaying] / 1e6);
+        if (replaying)
+        {
+            if (runTimes[0])
+            {
+                printf("saved:            %.3f s\n", (runTimes[0] - (double)runTimes[1]) / 1e6);
+            }
+            Sim_Report();
+        }
+    }
+    else if (Sim_Now - winTime == REPLAY_DELAY)
+    {
+        robot.x = startX;
+        robot.y = startY;
+        robot.heading = startHeading;
+        robot.vLeft = 0;
+        robot.vRight = 0;
+        P1->IFG |= 0x10; // right button: show the solution
+        runStart = Sim_Now;
+    }
+}
+
+// Presses the bump switches at bumpTime and releases them BUMP_HOLD later, and times how long the
+// motors take to go off and the wheels to stop.
+static void Sim_Bump(void)
+{
+    if (!bumpTime || (Sim_Now < bumpTime))
+    {
+        return;
+    }
+    if (Sim_Now == bumpTime)
+    {
+        P4->IN &= ~BUMP_SWITCHES;
+        P4->IFG |= P4->IES & BUMP_SWITCHES; // falling edge
+        bumpDistance = distance;
+    }
+    else if (Sim_Now == bumpTime + BUMP_HOLD)
+    {
+        P4->IN |= BUMP_SWITCHES; // rising edge
+        P4->IFG |= ~P4->IES & BUMP_SWITCHES;
+    }
+    if (!bumpOff && !Sim_MotorDuty(0x80, 0x80, 0x10, 4) && !Sim_MotorDuty(0x40, 0x40, 0x20, 3))
+    {
+        bumpOff = Sim_Now;
+    }
+    if (bumpOff && !bumpStill && (fabs(robot.vLeft) + fabs(robot.vRight) < 1))
+    {
+        bumpStill = Sim_Now;
+        bumpDistance = distance - bumpDistance;
+    }
+}
+
+// Advances simulated time by us microseconds, delivering interrupts along the way.
+void Sim_Advance(uint32_t us)
+{
+    while (us--)
+    {
+        Sim_Now++;
+        int i;
+        if (deepSleep) // MCLK and SMCLK are off
+        {
+            timer32Start++;
+            deepUs++;
+        }
+        else
+        {
+            for (i = 0; i < 4; i++)
+            {
+                Sim_TimerAStep(i);
+            }
+            Sim_SysTickStep();
+            Sim_Uart();
+        }
+        Sim_RtcStep();
+        Sim_LineSensors();
+        Sim_Dma();
+        Sim_Encoder(&robot.right, robot.vRight, 0, 0x01);
+        Sim_Encoder(&robot.left, robot.vLeft, 1, 0x04);
+        Sim_Bump();
+        if (Sim_Now % 1000 == 0)
+        {
+            Sim_Robot(0.001);
+            Sim_Maze();
+        }
+        if (Sim_Now == BUTTON_TIME) // press the left button to start running
+        {
+            if (Flash_Restored()) // an earlier run may have stored the solution: replay it straight away
+            {
+                P1->IFG |= 0x10;
+            }
+            else
+            {
+                P1->IFG |= 0x02;
+            }
+            lapStart = Sim_Now;
+            runStart = Sim_Now;
+        }
+        if (Sim_Now >= endTime)
+        {
+            Sim_Report();
+        }
+        Sim_Dispatch();
+    }
+}
+
+// Returns 1 if an interrupt is pending, which wakes WFI even while interrupts are disabled.
+static int Sim_Waking(void)
+{
+    unsigned i;
+    for (i = 0; i < NUM_SOURCES; i++)
+    {
+        if (Sim_Pending(&sources[i]))
+        {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// Sleeps until an interrupt handler has run, or with interrupts disabled, until one is pending.
+void Sim_WaitForInterrupt(void)
+{
+    uint32_t before = interruptCalls;
+    deepSleep = (SCB->SCR & 0x00000004) != 0;
+    while (interruptCalls == before)
+    {
+        Sim_Advance(1);
+        sleepUs++;
+        if (!interruptsEnabled && Sim_Waking())
+        {
+            break;
+        }
+    }
+    deepSleep = 0;
+}
+
+// GenInterrupts.c masks interrupts with the core's PRIMASK, and unmasking has to dispatch whatever is
+// pending right away, so the simulator supplies it.
+void DisableInterrupts(void)
+{
+    interruptsEnabled = 0;
+}
+
+void EnableInterrupts(void)
+{
+    interruptsEnabled = 1;
+    Sim_Dispatch();
+}
+
+uint32_t StartCritical(void)
+{
+    uint32_t sr = !interruptsEnabled; // PRIMASK is 1 when interrupts are off
+    interruptsEnabled = 0;
+    return sr;
+}
+
+void EndCritical(uint32_t sr)
+{
+    if (!sr)
+    {
+        EnableInterrupts();
+    }
+}
+
+void WaitForInterrupt(void)
+{
+    Sim_WaitForInterrupt();
+}
+
+// Puts the simulated hardware in its state out of reset and connects the firmware's interrupt handlers,
+// with the robot at the default track's start. Called by main, and by the host tests (Simulator/Test*.c)
+// in place of main. The simulation has no end time until main sets one.
+void Sim_Setup(void)
+{
+    Track_Default(&robot.x, &robot.y, &robot.heading);
+    endTime = UINT64_MAX;
+    sources[0].handler = SysTick_Handler;
+    sources[1].handler = TA0_0_IRQHandler;
+    sources[2].handler = TA1_0_IRQHandler;
+    sources[3].handler = TA2_0_IRQHandler;
+    sources[4].handler = TA3_0_IRQHandler;
+    sources[5].handler = TA3_N_IRQHandler;
+    sources[6].handler = PORT1_IRQHandler;
+    sources[7].handler = DMA_INT1_IRQHandler;
+    sources[8].handler = PORT4_IRQHandler;
+    sources[9].handler = RTC_C_IRQHandler;
+    sources[10].handler = DMA_INT2_IRQHandler;
+    P1->IN = 0xFF; // buttons released
+    P4->IN = 0xFF; // bump switches released
+    RTC_C->CTL13 = 0x0060; // reset value: held, calendar mode
+}
+
+int main(int argc, char **argv)
+{
+    double seconds = (argc > 1) ? atof(argv[1]) : 60;
+    Sim_Setup();
+    if (argc > 5)
+    {
+        if (Track_Load(argv[2]))
+        {
+            fprintf(stderr, "can't load %s (must be a binary PGM)\n", argv[2]);
+            return 1;
+        }
+        robot.x = atof(argv[3]);
+        robot.y = atof(argv[4]);
+        robot.heading = atof(argv[5]) * M_PI / 180;
+    }
+    startX = robot.x;
+    startY = robot.y;
+    startHeading = robot.heading;
+    endTime = BUTTON_TIME + (uint64_t)(seconds * 1e6);
+
+    if (getenv("SIM_TELEMETRY"))
+    {
+        telemetry = fopen(getenv("SIM_TELEMETRY"), "wb");
+    }
+    if (getenv("SIM_BUMP"))
+    {
+        bumpTime = BUTTON_TIME + (uint64_t)(atof(getenv("SIM_BUMP")) * 1e6);
+    }
+    Firmware_Main(); // never returns; Sim_Report exits
+    return 0;
+}
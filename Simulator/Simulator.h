@@ -0,0 +1,25 @@
+/* Simulator.h
+ * Shared declarations for the host simulator.
+ */
+
+#ifndef SIMULATOR_H
+#define SIMULATOR_H
+
+#include <stdint.h>
+
+extern uint64_t Sim_Now; // simulated time since reset, in us
+
+void Sim_Setup(void);
+void Sim_Advance(uint32_t us);
+void Sim_WaitForInterrupt(void);
+
+// Flash.c
+int Flash_Restored(void);
+void Flash_FailAfter(int operations);
+
+// Track.c
+int Track_Load(const char *path);
+void Track_Default(double *x, double *y, double *heading);
+double Track_Darkness(double x, double y);
+
+#endif
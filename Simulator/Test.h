@@ -0,0 +1,32 @@
+/* Test.h
+ * Checks for the host tests. Each Simulator/Test*.c is a program that links
+ * the firmware sources against the simulated hardware, like ./sim, and exits
+ * with 1 if any check failed. Simulator/test.sh builds and runs them all.
+ */
+
+#ifndef TEST_H
+#define TEST_H
+
+#include <stdio.h>
+
+static int testFailures; // checks that failed so far
+
+// Records a failure, with where it was, if "condition" is false.
+#define CHECK(condition) \
+    do \
+    { \
+        if (!(condition)) \
+        { \
+            printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+            testFailures++; \
+        } \
+    } while (0)
+
+// Prints the result for the test named "name" and returns the program's exit status.
+static inline int Test_Done(const char *name)
+{
+    printf("%s: %s\n", name, testFailures ? "FAIL" : "pass");
+    return testFailures ? 1 : 0;
+}
+
+#endif
@@ -0,0 +1,123 @@
+/* TestBumpers.c
+ * Host test of the bump switches in Bumpers.c, driven through the
+ * simulator's port registers: pressing a switch interrupts, the handler
+ * cuts both motors at once and queues one event, and the motors stay off
+ * until the main loop releases them.
+ */
+
+#include "msp.h"
+#include "Simulator.h"
+#include "MotionProfile.h"
+#include "Motor.h"
+#include "Timebase.h"
+#include "Bumpers.h"
+#include "Test.h"
+
+#define BUMP_PINS 0xED // P4.0, P4.2, P4.3, P4.5, P4.6 and P4.7
+#define ENTRY_CYCLES 12 // Bumpers.c's nominal exception entry
+#define HALT_CYCLES 480 // 10us of the host clock the simulated CYCCNT follows; Motor_Halt is a few register writes
+
+// Returns 1 if both motors are off: no duty, and both drivers asleep.
+static int Off(void)
+{
+    return (TIMER_A0->CCR[3] == 0) && (TIMER_A0->CCR[4] == 0) && !(P3->OUT & 0xC0);
+}
+
+// Closes the switches on "pins" (P4 bits), with the falling edge that interrupts, and lets 1us pass.
+static void Press(uint8_t pins)
+{
+    P4->IN &= ~pins;
+    P4->IFG |= pins & P4->IES;
+    Sim_Advance(1);
+}
+
+// Opens the switches on "pins" again. The rising edge doesn't interrupt.
+static void Let(uint8_t pins)
+{
+    P4->IN |= pins;
+    P4->IFG |= pins & ~P4->IES;
+    Sim_Advance(1);
+}
+
+int main(void)
+{
+    struct BumpEvent event;
+    int i;
+    Sim_Setup();
+    Timebase_Init();
+    Motor_Init();
+    Bumpers_Init();
+
+    // Inputs with pull-ups, interrupting on the falling edge, at the top priority.
+    CHECK(!(P4->DIR & BUMP_PINS) && ((P4->REN & BUMP_PINS) == BUMP_PINS) && ((P4->OUT & BUMP_PINS) == BUMP_PINS));
+    CHECK(((P4->IES & BUMP_PINS) == BUMP_PINS) && ((P4->IE & BUMP_PINS) == BUMP_PINS));
+    CHECK((NVIC->IP[38] == 0x00) && (NVIC->ISER[1] & 0x00000040));
+    CHECK(Bumpers_Read() == 0);
+
+    // Each pin reads as its own switch, right to left.
+    uint8_t pins[6] = { 0x01, 0x04, 0x08, 0x20, 0x40, 0x80 };
+    for (i = 0; i < 6; i++)
+    {
+        P4->IN &= ~pins[i]; // no edge flagged, so no interrupt
+        CHECK(Bumpers_Read() == (1 << i));
+        P4->IN |= pins[i];
+    }
+
+    // A hit on the middle switches cuts both motors within the microsecond and queues one event.
+    Motor_SetDuty(5000, -5000);
+    CHECK(!Off());
+    Press(0x28); // BUMP2 and BUMP3
+    CHECK(Off());
+    CHECK(Motor_Halted());
+    CHECK(P4->IFG == 0); // acknowledged
+    CHECK(Bumpers_Next(&event));
+    CHECK(event.switches == 0x0C);
+    CHECK(Timebase_NowUs() - event.time <= 2);
+    CHECK(!Bumpers_Next(&event));
+    CHECK(Bumpers_HaltCycles() >= ENTRY_CYCLES);
+    CHECK(Bumpers_HaltCycles() < ENTRY_CYCLES + HALT_CYCLES);
+
+    // The robot bouncing off the wall interrupts again but queues nothing more, and nothing turns the motors back on.
+    for (i = 0; i < 5; i++)
+    {
+        Let(0x28);
+        Press(0x08);
+    }
+    CHECK(!Bumpers_Next(&event));
+    Motor_SetDuty(5000, 5000);
+    CHECK(Off());
+    Let(0x28);
+
+    // Once released, the motors run again, and the next hit is queued with its own switches.
+    Motor_Release();
+    Motor_SetDuty(3000, 3000);
+    CHECK(!Off());
+    Press(0x81); // the two outside switches, BUMP0 and BUMP5
+    CHECK(Off());
+    CHECK(Bumpers_Next(&event) && (event.switches == 0x21));
+    Let(0x81);
+
+    // A pin that isn't a bump switch doesn't interrupt.
+    Motor_Release();
+    Motor_SetDuty(3000, 3000);
+    P4->IFG |= 0x12;
+    Sim_Advance(1);
+    CHECK(!Off() && !Motor_Halted());
+    P4->IFG = 0;
+
+    // Hits the main loop doesn't get to are counted once the queue is full.
+    CHECK(Bumpers_Overruns() == 0);
+    for (i = 0; i < 5; i++)
+    {
+        Motor_Release();
+        Press(0x04);
+        Let(0x04);
+    }
+    CHECK(Bumpers_Overruns() == 1);
+    for (i = 0; i < 4; i++)
+    {
+        CHECK(Bumpers_Next(&event) && (event.switches == 0x02));
+    }
+    CHECK(!Bumpers_Next(&event));
+    return Test_Done("TestBumpers");
+}
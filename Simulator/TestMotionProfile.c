@@ -0,0 +1,76 @@
+/* TestMotionProfile.c
+ * Host test of the setpoint generator in MotionProfile.c with limits well
+ * above the robot's own: a long move at the largest acceleration holds full
+ * speed until it has to brake and stops on its target, and a big speed change
+ * at a high jerk limit arrives without stalling. Both drive the 2 a d and
+ * 2 j dv products past 32 bits.
+ */
+
+#include "msp.h"
+#include "MotionProfile.h"
+#include "Test.h"
+
+#define TICK_MS 10 // the control period the profile is stepped at
+#define MAX_SPEED 600 // mm/s
+#define BIG_ACCEL 32767 // mm/s^2, the most struct Speeds can hold
+#define LONG_MOVE 100000000 // um (100m), far enough that 2 a d passes 2^32 for most of it
+
+// Moves LONG_MOVE at "accel" and "jerk" and checks the speed stays at MAX_SPEED from the moment
+// it gets there until the last metre, then stops on the target in about the time it should take.
+// (At these limits the 10ms ticks are coarse, so the stop may overshoot a little and come back.)
+static void LongMove(int32_t accel, int32_t jerk)
+{
+    struct MotionProfile p;
+    uint32_t ticks = 0;
+    uint8_t cruising = 0;
+    int16_t speed;
+    MotionProfile_Init(&p, MAX_SPEED, accel, jerk);
+    MotionProfile_MoveTo(&p, LONG_MOVE);
+    while (!MotionProfile_Done(&p) && (ticks < 2 * LONG_MOVE / 1000 / MAX_SPEED * 1000 / TICK_MS))
+    {
+        speed = MotionProfile_Step(&p, TICK_MS);
+        ticks++;
+        CHECK(speed <= MAX_SPEED);
+        if (speed == MAX_SPEED)
+        {
+            cruising = 1;
+        }
+        else if (cruising && (p.position < LONG_MOVE - 1000000))
+        {
+            CHECK(speed == MAX_SPEED); // braked early
+            cruising = 0; // report it once
+        }
+    }
+    CHECK(MotionProfile_Done(&p) && (p.position == LONG_MOVE));
+    CHECK(ticks < (LONG_MOVE / 1000 / MAX_SPEED + 5) * 1000 / TICK_MS); // within 5s of the time at full speed
+}
+
+// Cruises from rest to "speed" at BIG_ACCEL and "jerk" and checks it gets there, without overshooting,
+// in about the time the limits allow.
+static void SpeedChange(int16_t speed, int32_t jerk)
+{
+    struct MotionProfile p;
+    uint32_t ticks = 0;
+    int16_t v = 0;
+    MotionProfile_Init(&p, speed, BIG_ACCEL, jerk);
+    MotionProfile_Cruise(&p, speed);
+    while ((v != speed) && (ticks < 1000))
+    {
+        v = MotionProfile_Step(&p, TICK_MS);
+        ticks++;
+        CHECK((v >= 0) && (v <= speed));
+    }
+    CHECK(v == speed);
+    CHECK(ticks <= (speed * 1000 / BIG_ACCEL + BIG_ACCEL * 1000 / jerk) / TICK_MS + 2); // v / a + a / j, and a tick each end
+}
+
+int main(void)
+{
+    LongMove(BIG_ACCEL, 0);
+    LongMove(BIG_ACCEL, 30000);
+    LongMove(BIG_ACCEL, 1000000);
+    SpeedChange(10000, 1000000);
+    SpeedChange(30000, 1000000);
+    SpeedChange(30000, 100000);
+    return Test_Done("TestMotionProfile");
+}
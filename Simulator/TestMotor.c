@@ -0,0 +1,77 @@
+/* TestMotor.c
+ * Host test of the Timer A0 PWM in Motor.c, on the register mock: each duty
+ * lands in the right compare register and direction pin, and wakes or
+ * sleeps the right driver.
+ */
+
+#include "msp.h"
+#include "Simulator.h"
+#include "MotionProfile.h"
+#include "Motor.h"
+#include "Test.h"
+
+#define LEFT_PWM TIMER_A0->CCR[4] // P2.7, TA0.4
+#define RIGHT_PWM TIMER_A0->CCR[3] // P2.6, TA0.3
+#define LEFT_BACKWARD (P5->OUT & 0x10)
+#define RIGHT_BACKWARD (P5->OUT & 0x20)
+#define LEFT_AWAKE (P3->OUT & 0x80)
+#define RIGHT_AWAKE (P3->OUT & 0x40)
+
+int main(void)
+{
+    int16_t left, right;
+    Sim_Setup();
+    Motor_Init();
+
+    // 10000 counts of 12MHz SMCLK in up mode is a 1.2kHz period, and the duty units are those counts.
+    CHECK(TIMER_A0->CCR[0] == 9999);
+    CHECK((TIMER_A0->CTL & 0x0330) == 0x0210); // SMCLK, up mode
+    CHECK((TIMER_A0->CTL & 0x00C0) == 0); // divider /1
+    CHECK(TIMER_A0->EX0 == 0);
+    CHECK(TIMER_A0->CCTL[3] == 0x00E0); // reset/set
+    CHECK(TIMER_A0->CCTL[4] == 0x00E0);
+    CHECK((P2->SEL0 & 0xC0) == 0xC0); // P2.6 and P2.7 driven by the timer
+    CHECK((P2->SEL1 & 0xC0) == 0);
+    CHECK(!LEFT_AWAKE && !RIGHT_AWAKE); // both drivers asleep until a duty is set
+
+    Motor_SetDuty(2500, 7500);
+    CHECK(LEFT_PWM == 2500);
+    CHECK(RIGHT_PWM == 7500);
+    CHECK(!LEFT_BACKWARD && !RIGHT_BACKWARD);
+    CHECK(LEFT_AWAKE && RIGHT_AWAKE);
+    Motor_GetDuty(&left, &right);
+    CHECK((left == 2500) && (right == 7500));
+
+    Motor_SetDuty(-3000, 4000); // a negative duty reverses just that wheel
+    CHECK(LEFT_PWM == 3000);
+    CHECK(RIGHT_PWM == 4000);
+    CHECK(LEFT_BACKWARD && !RIGHT_BACKWARD);
+    Motor_GetDuty(&left, &right);
+    CHECK((left == -3000) && (right == 4000));
+
+    Motor_SetDuty(0, -5000); // a zero duty sleeps that driver
+    CHECK(LEFT_PWM == 0);
+    CHECK(!LEFT_AWAKE && RIGHT_AWAKE);
+    CHECK(RIGHT_BACKWARD);
+
+    Motor_SetDuty(12000, -12000); // out of range clamps to full duty
+    CHECK(LEFT_PWM == 10000);
+    CHECK(RIGHT_PWM == 10000);
+    Motor_GetDuty(&left, &right);
+    CHECK((left == 10000) && (right == -10000));
+
+    Motor_Halt(); // everything off, and kept off until released
+    CHECK((LEFT_PWM == 0) && (RIGHT_PWM == 0));
+    CHECK(!LEFT_AWAKE && !RIGHT_AWAKE);
+    Motor_SetDuty(4000, 4000);
+    CHECK((LEFT_PWM == 0) && (RIGHT_PWM == 0));
+    CHECK(!LEFT_AWAKE && !RIGHT_AWAKE);
+    Motor_Release();
+    Motor_SetDuty(4000, 4000);
+    CHECK((LEFT_PWM == 4000) && (RIGHT_PWM == 4000));
+
+    Motor_StopSimple();
+    CHECK((LEFT_PWM == 0) && (RIGHT_PWM == 0));
+    CHECK(!LEFT_AWAKE && !RIGHT_AWAKE);
+    return Test_Done("TestMotor");
+}
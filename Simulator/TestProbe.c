@@ -0,0 +1,60 @@
+/* TestProbe.c
+ * Host test of the cycle-count probes in Probe.c. The simulated DWT cycle
+ * counter is stopped and set by hand around PROBE_BEGIN and PROBE_END, so
+ * each measurement is a known number of cycles: the statistics must add up,
+ * a measurement across the counter wrapping from 0xFFFFFFFF to 0 must
+ * come out right, and the total must go past 32 bits without losing any.
+ */
+
+#include "msp.h"
+#include "Probe.h"
+#include "Test.h"
+
+// Measures exactly "cycles" on PROBE_CONTROL, starting with the cycle counter at "start".
+static void Measure(uint32_t start, uint32_t cycles)
+{
+    DWT->CYCCNT = start;
+    PROBE_BEGIN(PROBE_CONTROL);
+    DWT->CYCCNT = start + cycles;
+    PROBE_END(PROBE_CONTROL);
+}
+
+int main(void)
+{
+    struct ProbeStats stats;
+    Probe_Init();
+    CHECK((CoreDebug->DEMCR & 0x01000000) && (DWT->CTRL & 0x00000001)); // the counter runs
+    DWT->CTRL &= ~0x00000001; // and is stopped for the test, so it only changes when set
+
+    // Nothing recorded yet.
+    Probe_Get(PROBE_CONTROL, &stats);
+    CHECK((stats.count == 0) && (stats.max == 0) && (stats.total == 0) && (stats.min == 0xFFFFFFFF));
+
+    // Known measurements give their count, smallest, largest and sum.
+    Measure(1000, 250);
+    Measure(5000, 100);
+    Measure(9000, 400);
+    Probe_Get(PROBE_CONTROL, &stats);
+    CHECK((stats.count == 3) && (stats.min == 100) && (stats.max == 400) && (stats.total == 750));
+
+    // A measurement that spans the counter wrapping is the cycles that passed, not a huge or negative number.
+    Measure(0xFFFFFF00, 0x200);
+    Probe_Get(PROBE_CONTROL, &stats);
+    CHECK((stats.count == 4) && (stats.max == 0x200) && (stats.total == 750 + 0x200));
+
+    // Other probes are untouched.
+    Probe_Get(PROBE_SPEED, &stats);
+    CHECK(stats.count == 0);
+
+    // Reset clears the statistics; then long measurements take the total past 32 bits.
+    Probe_Reset();
+    Probe_Get(PROBE_CONTROL, &stats);
+    CHECK((stats.count == 0) && (stats.max == 0) && (stats.total == 0) && (stats.min == 0xFFFFFFFF));
+    Measure(0x80000000, 0xF0000000);
+    Measure(0x10, 0xF0000000);
+    Measure(0, 1);
+    Probe_Get(PROBE_CONTROL, &stats);
+    CHECK((stats.count == 3) && (stats.min == 1) && (stats.max == 0xF0000000));
+    CHECK(stats.total == 2 * 0xF0000000ull + 1);
+    return Test_Done("TestProbe");
+}
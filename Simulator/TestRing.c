@@ -0,0 +1,163 @@
+/* TestRing.c
+ * Host test of the single-producer single-consumer ring in Ring.h. The
+ * single-threaded part checks the bookkeeping; then a producer thread and
+ * a consumer thread hammer a small ring with a million items, which
+ * wraps the 16-bit indexes many times over. Every item must arrive whole,
+ * in order and once, and every item that didn't arrive must have been
+ * counted as an overrun.
+ */
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdint.h>
+#include "msp.h"
+#include "RamFunc.h"
+#include "Ring.h"
+#include "Test.h"
+
+#define CAPACITY 8
+#define ITEMS 1000000 // per run
+
+struct Item
+{
+    uint32_t sequence;
+    uint32_t check; // ~sequence, so a slot read while it was being written shows up
+};
+
+static struct Item items[CAPACITY];
+static struct Ring ring = RING_INIT(CAPACITY);
+static int retry; // whether the producer tries again when the ring is full, or drops the item
+static volatile int producing; // the producer hasn't finished yet
+
+static void *Producer(void *arg)
+{
+    uint32_t n = 0;
+    (void)arg;
+    while (n < ITEMS)
+    {
+        int16_t slot = Ring_Reserve(&ring);
+        if (slot >= 0)
+        {
+            items[slot].sequence = n;
+            items[slot].check = ~n;
+            Ring_Publish(&ring);
+            n++;
+        }
+        else
+        {
+            if (!retry)
+            {
+                n++; // dropped; Ring_Reserve counted it
+            }
+            sched_yield(); // like the robot's main loop sleeping, and so a single core gets to the consumer
+        }
+    }
+    __DMB();
+    producing = 0;
+    return 0;
+}
+
+// Runs one producer and one consumer thread to the end, checking the items on the consumer's side.
+static void Run(int retrying)
+{
+    pthread_t producer;
+    uint32_t received = 0, dropped = 0, torn = 0, backwards = 0;
+    int64_t last = -1;
+    ring.head = 0;
+    ring.tail = 0;
+    ring.overruns = 0;
+    retry = retrying;
+    producing = 1;
+    pthread_create(&producer, 0, Producer, 0);
+    while (1)
+    {
+        int done = !producing; // read before the ring, so the last item isn't missed
+        __DMB();
+        int16_t slot = Ring_Front(&ring);
+        if (slot < 0)
+        {
+            if (done)
+            {
+                break;
+            }
+            sched_yield();
+            continue;
+        }
+        struct Item item = items[slot];
+        Ring_Pop(&ring);
+        if (item.check != ~item.sequence)
+        {
+            torn++;
+        }
+        else if ((int64_t)item.sequence <= last)
+        {
+            backwards++;
+        }
+        else
+        {
+            dropped += item.sequence - last - 1;
+            last = item.sequence;
+        }
+        received++;
+    }
+    pthread_join(producer, 0);
+    dropped += ITEMS - 1 - last;
+    CHECK(torn == 0);
+    CHECK(backwards == 0);
+    CHECK(received + dropped == ITEMS);
+    CHECK(Ring_Count(&ring) == 0);
+    if (retrying)
+    {
+        CHECK(dropped == 0); // the producer counts an overrun each time it finds the ring full, though
+    }
+    else
+    {
+        CHECK((uint16_t)dropped == ring.overruns); // the counter is 16-bit
+        CHECK(received > 0);
+    }
+}
+
+int main(void)
+{
+    int i;
+
+    // Bookkeeping on one thread: fills to capacity, refuses and counts the next, and drains in order.
+    for (i = 0; i < CAPACITY; i++)
+    {
+        int16_t slot = Ring_Reserve(&ring);
+        CHECK(slot == i);
+        items[slot].sequence = i;
+        Ring_Publish(&ring);
+        CHECK(Ring_Count(&ring) == i + 1);
+    }
+    CHECK(Ring_Reserve(&ring) == -1);
+    CHECK(ring.overruns == 1);
+    for (i = 0; i < CAPACITY; i++)
+    {
+        int16_t slot = Ring_Front(&ring);
+        CHECK((slot >= 0) && (items[slot].sequence == (uint32_t)i));
+        Ring_Pop(&ring);
+    }
+    CHECK(Ring_Front(&ring) == -1);
+    CHECK(Ring_Count(&ring) == 0);
+
+    // The indexes wrap at 65536 without the ring noticing.
+    ring.head = ring.tail = 65534;
+    for (i = 0; i < 4; i++)
+    {
+        items[Ring_Reserve(&ring)].sequence = i;
+        Ring_Publish(&ring);
+    }
+    CHECK(Ring_Count(&ring) == 4);
+    for (i = 0; i < 4; i++)
+    {
+        int16_t slot = Ring_Front(&ring);
+        CHECK((slot >= 0) && (items[slot].sequence == (uint32_t)i));
+        Ring_Pop(&ring);
+    }
+    CHECK(Ring_Count(&ring) == 0);
+
+    Run(1); // nothing may be lost
+    Run(0); // losses must all be counted
+    return Test_Done("TestRing");
+}
@@ -0,0 +1,163 @@
+/* TestStore.c
+ * Host test of the flash key/value store in Store.c, on the simulator's
+ * flash: records read back, a damaged record is caught by its CRC, the
+ * sectors change over when one fills up, and the power failing at any
+ * point in a write leaves the store readable after a restart.
+ */
+
+#include <string.h>
+#include "msp.h"
+#include "Simulator.h"
+#include "Flash.h"
+#include "Store.h"
+#include "Test.h"
+
+#define STORE_MAGIC 0x31545352 // Store.c's sector header
+#define RECORD_LENGTH 16 // bytes in the records the test writes to STORE_ROUTE
+
+static uint8_t calibration[12] = { 10, 20, 30, 40, 50, 60, 70, 80, 90, 100, 110, 120 }; // sits in the store while STORE_ROUTE is rewritten
+
+// Fills "route" with a pattern that is different for each "n".
+static void Route(uint8_t *route, uint32_t n)
+{
+    uint8_t i;
+    for (i = 0; i < RECORD_LENGTH; i++)
+    {
+        route[i] = n * 7 + i;
+    }
+}
+
+// Erases the store, as on a new chip, and stores the calibration record.
+static void Fresh(void)
+{
+    Flash_Erase(0);
+    Flash_Erase(1);
+    Store_Init();
+    Store_Write(STORE_CALIBRATION, calibration, sizeof(calibration));
+}
+
+// Returns 1 if the calibration record reads back unchanged.
+static int Others(void)
+{
+    uint8_t c[sizeof(calibration)];
+    return Store_Read(STORE_CALIBRATION, c, sizeof(c)) && !memcmp(c, calibration, sizeof(c));
+}
+
+// Returns 1 if the STORE_ROUTE record reads back as route number "n".
+static int RouteIs(uint32_t n)
+{
+    uint8_t want[RECORD_LENGTH], got[RECORD_LENGTH];
+    Route(want, n);
+    return Store_Read(STORE_ROUTE, got, sizeof(got)) && !memcmp(got, want, sizeof(got));
+}
+
+// Returns the sequence number in the header of the sector Store.c is using: the later valid one.
+static int32_t Sequence(void)
+{
+    const uint32_t *a = Flash_Sector(0), *b = Flash_Sector(1);
+    if ((a[0] == STORE_MAGIC) && ((b[0] != STORE_MAGIC) || ((int32_t)(a[1] - b[1]) > 0)))
+    {
+        return a[1];
+    }
+    return (b[0] == STORE_MAGIC) ? (int32_t)b[1] : -1;
+}
+
+int main(void)
+{
+    uint8_t route[RECORD_LENGTH], small[4];
+    uint32_t n, fill, refill;
+    int after;
+
+    // Round trip, and what a read leaves alone.
+    Fresh();
+    CHECK((Flash_Sector(0)[0] == STORE_MAGIC) && (Sequence() == 0));
+    CHECK(Store_Read(STORE_ROUTE, route, sizeof(route)) == 0); // nothing stored
+    Route(route, 1);
+    CHECK(Store_Write(STORE_ROUTE, route, sizeof(route)));
+    CHECK(RouteIs(1) && Others());
+    CHECK(Store_Read(STORE_ROUTE, small, sizeof(small)) == 0); // wrong length
+    Route(route, 2);
+    Store_Write(STORE_ROUTE, route, sizeof(route));
+    CHECK(RouteIs(2));
+    Store_Init(); // a restart
+    CHECK(RouteIs(2) && Others());
+
+    // Writing what is there already programs nothing.
+    Flash_FailAfter(0);
+    CHECK(Store_Write(STORE_ROUTE, route, sizeof(route)));
+    Flash_FailAfter(-1);
+    Store_Init();
+    CHECK(RouteIs(2));
+
+    // A record whose data no longer matches its CRC is skipped, and the one before it is read instead.
+    // The record for route 2 is the last one, and programming can still clear bits in it.
+    const uint32_t *words = Flash_Sector(0);
+    uint16_t last = 2;
+    while (words[last + 1 + (((words[last] >> 8) & 0xFF) + 3) / 4] != FLASH_ERASED)
+    {
+        last += 1 + (((words[last] >> 8) & 0xFF) + 3) / 4;
+    }
+    CHECK((words[last] & 0xFF) == STORE_ROUTE);
+    Flash_Program(0, last + 2, words[last + 2] & (words[last + 2] - 1)); // clears one bit of the data
+    Store_Init();
+    CHECK(RouteIs(1) && Others());
+
+    // Filling the sector moves the latest records into the other one, which takes over; and back again.
+    Fresh();
+    for (fill = 1; Sequence() == 0; fill++)
+    {
+        Route(route, fill);
+        CHECK(Store_Write(STORE_ROUTE, route, sizeof(route)));
+    }
+    fill--; // the write that changed over
+    CHECK((Flash_Sector(1)[0] == STORE_MAGIC) && (Sequence() == 1));
+    CHECK(fill > 100); // records were appended, not erased for
+    CHECK(RouteIs(fill) && Others());
+    Store_Init();
+    CHECK(RouteIs(fill) && Others());
+    for (n = fill + 1; Sequence() == 1; n++)
+    {
+        Route(route, n);
+        Store_Write(STORE_ROUTE, route, sizeof(route));
+    }
+    refill = n - 1;
+    CHECK(Sequence() == 2); // back in sector 0, which beats the older sector 1
+    CHECK(RouteIs(refill) && Others());
+    Store_Init();
+    CHECK(RouteIs(refill) && Others());
+
+    // The power fails after each number of flash operations in turn, in an ordinary write, in the first
+    // changeover (into an empty sector) and in the second (over the sector used first). After a restart the
+    // record reads as before or after the write, the others are intact, and the store carries on working.
+    uint32_t writes[] = { 5, fill, refill };
+    int w;
+    for (w = 0; w < 3; w++)
+    {
+        for (after = 0; after < 64; after++)
+        {
+            Fresh();
+            for (n = 1; n < writes[w]; n++)
+            {
+                Route(route, n);
+                Store_Write(STORE_ROUTE, route, sizeof(route));
+            }
+            if (w == 2)
+            {
+                CHECK(Sequence() == 1);
+            }
+            Route(route, n);
+            Flash_FailAfter(after);
+            Store_Write(STORE_ROUTE, route, sizeof(route));
+            Flash_FailAfter(-1);
+            Store_Init();
+            CHECK(RouteIs(n - 1) || RouteIs(n));
+            CHECK(Others());
+            Route(route, n + 1);
+            CHECK(Store_Write(STORE_ROUTE, route, sizeof(route)));
+            CHECK(RouteIs(n + 1) && Others());
+            Store_Init();
+            CHECK(RouteIs(n + 1) && Others());
+        }
+    }
+    return Test_Done("TestStore");
+}
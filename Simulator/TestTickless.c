@@ -0,0 +1,199 @@
+/* TestTickless.c
+ * Host test of the tickless SysTick in SysTick.c and Scheduler.c: the
+ * next-release calculation against a tick-by-tick model of the task table,
+ * the LOAD values the handler programs, overshooting ticks and the misses
+ * they count, and the tasks running on time with the simulated SysTick.
+ */
+
+#include "msp.h"
+#include "Simulator.h"
+#include "Timebase.h"
+#include "Scheduler.h"
+#include "SysTick.h"
+#include "Test.h"
+
+#define TICK_COUNTS (0xBB80 + 1) // SysTick counts per tick: SysTickInterval + 1
+#define MAX_TICKS 300 // SysTick.c's
+
+static void Nothing(void)
+{
+}
+
+static uint32_t runs[3]; // calls of Count0..2 in the last part
+static uint64_t late[3]; // longest time from a task's release tick to its call, in us
+
+// Records a run of task "i", which should be on a whole number of ms since "start" plus the task's releases.
+static uint64_t start;
+static struct Task *table;
+static void Count(int i)
+{
+    uint64_t us = Sim_Now - start;
+    uint64_t release = (us / 1000 - table[i].offset - 1) / table[i].period * table[i].period + table[i].offset + 1;
+    if (us - release * 1000 > late[i])
+    {
+        late[i] = us - release * 1000;
+    }
+    runs[i]++;
+}
+
+static void Count0(void)
+{
+    Count(0);
+}
+
+static void Count1(void)
+{
+    Count(1);
+}
+
+static void Count2(void)
+{
+    Count(2);
+}
+
+// Returns 1 if "task" (as set up, before any ticks) is released on "tick", counting from Scheduler_Start.
+static int Releases(const struct Task *task, uint32_t tick)
+{
+    return (tick >= task->offset + 1u) && ((tick - task->offset - 1) % task->period == 0);
+}
+
+// Checks Scheduler_NextRelease(after) for every "after" up to "span", "now" ticks after Scheduler_Start.
+static void CheckNext(const struct Task *tasks, int count, uint32_t now, uint32_t span)
+{
+    uint32_t after, tick;
+    for (after = 0; after <= span; after++)
+    {
+        for (tick = now + after + 1; tick < now + after + 0xFFFF; tick++)
+        {
+            int i, any = 0;
+            for (i = 0; i < count; i++)
+            {
+                any |= Releases(&tasks[i], tick);
+            }
+            if (any)
+            {
+                break;
+            }
+        }
+        CHECK(Scheduler_NextRelease(after) == tick - now - after);
+    }
+}
+
+// Drives SysTick_Handler by hand for "ticks" ticks, as the counter would call it, and checks each period
+// the handler programs ends on the next tick that releases a task, or MAX_TICKS on if that comes first.
+// Returns the number of interrupts it took.
+static uint32_t Drive(struct Task *tasks, int count, uint32_t ticks)
+{
+    uint32_t now = 0, interrupts = 0;
+    uint32_t running = 1; // SysTick_Restart: one tick, then LOAD
+    int i;
+    SysTick_Restart();
+    Scheduler_Start();
+    while (now < ticks)
+    {
+        uint32_t tick, load = SysTick->LOAD; // the counter reloads from this as the period ends
+        for (tick = now + 1; tick < now + running; tick++) // a release inside the period would be late
+        {
+            for (i = 0; i < count; i++)
+            {
+                CHECK(!Releases(&tasks[i], tick));
+            }
+        }
+        now += running;
+        SysTick_Handler();
+        interrupts++;
+        for (i = 0; i < count; i++)
+        {
+            CHECK(tasks[i].ready == Releases(&tasks[i], now));
+        }
+        while (Scheduler_Run()) // main catches up before the next tick
+        {
+        }
+        CHECK((load + 1) % TICK_COUNTS == 0);
+        running = (load + 1) / TICK_COUNTS;
+        CHECK((running >= 1) && (running <= MAX_TICKS));
+        CHECK((SysTick->LOAD + 1) % TICK_COUNTS == 0);
+    }
+    for (i = 0; i < count; i++)
+    {
+        CHECK(tasks[i].misses == 0);
+    }
+    return interrupts;
+}
+
+int main(void)
+{
+    int i;
+    Sim_Setup();
+    Timebase_Init();
+
+    // The next release, from the start and after some ticks, against the tick-by-tick model.
+    struct Task tasks[3] = {
+        { "fast", Nothing, 2, 0 },
+        { "mid", Nothing, 5, 1 },
+        { "slow", Nothing, 20, 3 },
+    };
+    Scheduler_Init(tasks, 3);
+    CHECK(Scheduler_NextRelease(0) == 1); // offset 0 releases on the first tick
+    CheckNext(tasks, 3, 0, 100);
+
+    // A lone slow task: the next release can be further off than SysTick can count.
+    struct Task slow[1] = { { "slow", Nothing, 1000, 499 } };
+    Scheduler_Init(slow, 1);
+    CHECK(Scheduler_NextRelease(0) == 500);
+    CHECK(Scheduler_NextRelease(499) == 1);
+    CHECK(Scheduler_NextRelease(500) == 1000);
+    CheckNext(slow, 1, 0, 1500);
+
+    // An overshooting tick releases a task once and counts the releases it couldn't run as misses.
+    struct Task one[1] = { { "one", Nothing, 2, 0 } };
+    Scheduler_Init(one, 1);
+    Scheduler_Tick(5); // releases on ticks 1, 3 and 5
+    CHECK(one[0].ready && (one[0].misses == 2));
+    CHECK(Scheduler_NextRelease(0) == 2);
+    Scheduler_Tick(1);
+    CHECK(Scheduler_NextRelease(0) == 1);
+    CHECK(Scheduler_Run() && !Scheduler_Run() && (one[0].runs == 1));
+    Scheduler_Tick(1); // tick 7
+    CHECK(one[0].ready && (one[0].misses == 2));
+
+    // The handler's LOAD values end each period on the next release: a tick per release for the busy table,
+    // and MAX_TICKS at a time for the slow task.
+    for (i = 0; i < 3; i++)
+    {
+        tasks[i].misses = 0;
+    }
+    Scheduler_Init(tasks, 3);
+    uint32_t interrupts = Drive(tasks, 3, 2000);
+    CHECK(interrupts < 2000 * 3 / 4); // ticks that release nothing are skipped
+    Scheduler_Init(slow, 1);
+    interrupts = Drive(slow, 1, 5000);
+    CHECK(interrupts <= 5 * (1000 / MAX_TICKS + 2)); // around 4 periods per release, not 1000
+
+    // With the simulated SysTick counting, main wakes for each release and runs the task in time.
+    struct Task counted[3] = {
+        { "count0", Count0, 1, 0 },
+        { "count1", Count1, 7, 2 },
+        { "count2", Count2, 250, 10 },
+    };
+    table = counted;
+    Scheduler_Init(counted, 3);
+    start = Sim_Now;
+    SysTick_Init();
+    while (Sim_Now - start < 2000000 - 500) // 2s, stopping clear of a release
+    {
+        if (!Scheduler_Run())
+        {
+            Sim_WaitForInterrupt();
+        }
+    }
+    CHECK(runs[0] == 1999);
+    CHECK(runs[1] == (2000 - 3) / 7 + 1);
+    CHECK(runs[2] == (2000 - 11) / 250 + 1);
+    for (i = 0; i < 3; i++)
+    {
+        CHECK(late[i] < 100);
+        CHECK(counted[i].misses == 0);
+    }
+    return Test_Done("TestTickless");
+}
@@ -0,0 +1,231 @@
+/* TestTimerWheel.c
+ * Host test of the software timers in TimerWheel.c, ticked by hand: when
+ * one-shot and periodic timers fire, cancelling, stale handles, running
+ * out of timers, delays of more than one turn of the wheel, and callbacks
+ * that start and cancel timers.
+ */
+
+#include <stdint.h>
+#include "TimerWheel.h"
+#include "Test.h"
+
+#define WHEEL_SLOTS 32 // TimerWheel.c's
+#define POOL_SIZE 16
+
+static uint32_t now; // ticks since the test's TimerWheel_Init
+static uint32_t firstA, lastA, countA; // when A fired first and last, and how often
+static uint32_t lastB, countB;
+static uint16_t handleSelf; // the timer CancelSelf runs on
+static uint16_t handleD, handleE; // a pair of timers that cancel each other
+static uint32_t countDE; // how often either of them fired
+static uint16_t handleC; // the timer Restart starts
+
+static void A(void)
+{
+    if (countA == 0)
+    {
+        firstA = now;
+    }
+    lastA = now;
+    countA++;
+}
+
+static void B(void)
+{
+    lastB = now;
+    countB++;
+}
+
+// Cancels its own timer.
+static void CancelSelf(void)
+{
+    TimerWheel_Cancel(handleSelf);
+}
+
+// D and E cancel each other, so whichever fires first stops the other.
+static void D(void)
+{
+    countDE++;
+    TimerWheel_Cancel(handleE);
+}
+
+static void E(void)
+{
+    countDE++;
+    TimerWheel_Cancel(handleD);
+}
+
+// Starts a one-shot A 3 ticks on, from inside a callback.
+static void Restart(void)
+{
+    handleC = TimerWheel_Start(A, 3, 0);
+}
+
+static void Reset(void)
+{
+    TimerWheel_Init();
+    now = 0;
+    firstA = lastA = countA = 0;
+    lastB = countB = 0;
+}
+
+static void Tick(uint32_t ticks)
+{
+    while (ticks--)
+    {
+        now++;
+        TimerWheel_Tick();
+    }
+}
+
+int main(void)
+{
+    uint16_t a, b, handles[POOL_SIZE];
+    int i;
+
+    // One-shot: fires on the delay'th tick, once, and frees its timer.
+    Reset();
+    a = TimerWheel_Start(A, 5, 0);
+    CHECK(a != TIMERWHEEL_NONE);
+    CHECK(TimerWheel_Pending(a) && (TimerWheel_Active() == 1));
+    Tick(4);
+    CHECK(countA == 0);
+    Tick(1);
+    CHECK((countA == 1) && (firstA == 5));
+    CHECK(!TimerWheel_Pending(a) && (TimerWheel_Active() == 0));
+    Tick(100);
+    CHECK(countA == 1);
+    CHECK(TimerWheel_Cancel(a) == 0); // already expired
+
+    // A delay of 0 counts as 1.
+    Reset();
+    TimerWheel_Start(A, 0, 0);
+    Tick(1);
+    CHECK((countA == 1) && (firstA == 1));
+
+    // Periodic: first after the delay, then every period, without drifting.
+    Reset();
+    a = TimerWheel_Start(A, 2, 7);
+    Tick(2 + 7 * 20);
+    CHECK((firstA == 2) && (countA == 21) && (lastA == 2 + 7 * 20));
+    CHECK(TimerWheel_Pending(a));
+    CHECK(TimerWheel_Cancel(a) == 1);
+    CHECK(TimerWheel_Cancel(a) == 0);
+    Tick(50);
+    CHECK(countA == 21);
+
+    // Cancelling one timer leaves the others in the same slot alone.
+    Reset();
+    a = TimerWheel_Start(A, 10, 0);
+    b = TimerWheel_Start(B, 10, 0);
+    TimerWheel_Cancel(a);
+    Tick(10);
+    CHECK((countA == 0) && (countB == 1) && (lastB == 10));
+
+    // A handle goes stale once its timer is freed, even after the timer is reused.
+    Reset();
+    a = TimerWheel_Start(A, 1, 0);
+    Tick(1);
+    b = TimerWheel_Start(B, 5, 0);
+    CHECK((b & 0xFF) == (a & 0xFF)); // same timer from the pool, new generation
+    CHECK(b != a);
+    CHECK(!TimerWheel_Pending(a));
+    CHECK(TimerWheel_Cancel(a) == 0);
+    CHECK(TimerWheel_Pending(b));
+    Tick(5);
+    CHECK(countB == 1);
+
+    // Stale handles stay stale across the 8-bit generation wrapping, and never equal TIMERWHEEL_NONE.
+    Reset();
+    a = TimerWheel_Start(A, 1, 0);
+    TimerWheel_Cancel(a);
+    for (i = 0; i < 300; i++)
+    {
+        b = TimerWheel_Start(B, 1, 0);
+        CHECK(b != TIMERWHEEL_NONE);
+        CHECK((b == a) || !TimerWheel_Pending(a));
+        TimerWheel_Cancel(b);
+    }
+    CHECK(TimerWheel_Cancel(TIMERWHEEL_NONE) == 0);
+    CHECK(TimerWheel_Cancel(0xFFFF) == 0); // index out of the pool
+
+    // Running out: the 17th timer is refused, and freeing one makes room again.
+    Reset();
+    for (i = 0; i < POOL_SIZE; i++)
+    {
+        handles[i] = TimerWheel_Start(A, 1 + i, 0);
+        CHECK(handles[i] != TIMERWHEEL_NONE);
+    }
+    CHECK(TimerWheel_Start(B, 1, 0) == TIMERWHEEL_NONE);
+    CHECK(TimerWheel_Active() == POOL_SIZE);
+    TimerWheel_Cancel(handles[7]);
+    CHECK(TimerWheel_Start(B, 1, 0) != TIMERWHEEL_NONE);
+    Tick(POOL_SIZE);
+    CHECK((countA == POOL_SIZE - 1) && (countB == 1) && (TimerWheel_Active() == 0));
+
+    // Delays of one or more whole turns wait out their rounds: exactly WHEEL_SLOTS, one more, many turns,
+    // and the longest delay there is.
+    uint16_t delays[] = { WHEEL_SLOTS - 1, WHEEL_SLOTS, WHEEL_SLOTS + 1, 3 * WHEEL_SLOTS, 1000, 65535 };
+    for (i = 0; i < (int)(sizeof(delays) / sizeof(delays[0])); i++)
+    {
+        Reset();
+        Tick(i * 5); // start with the cursor somewhere else each time
+        uint32_t start = now;
+        TimerWheel_Start(A, delays[i], 0);
+        Tick(delays[i] - 1);
+        CHECK(countA == 0);
+        Tick(1);
+        CHECK((countA == 1) && (firstA - start == delays[i]));
+    }
+
+    // Timers due in the same slot on different turns fire on their own turns.
+    Reset();
+    TimerWheel_Start(A, 3 + 2 * WHEEL_SLOTS, 0);
+    TimerWheel_Start(B, 3, 0);
+    Tick(3);
+    CHECK((countA == 0) && (countB == 1));
+    Tick(2 * WHEEL_SLOTS);
+    CHECK((countA == 1) && (firstA == 3 + 2 * WHEEL_SLOTS));
+
+    // Periods longer than the wheel re-arm with rounds each time, across many wraps of the cursor.
+    Reset();
+    TimerWheel_Start(A, 100, 100);
+    Tick(100 * 50);
+    CHECK((countA == 50) && (firstA == 100) && (lastA == 100 * 50));
+
+    // A period a multiple of the wheel lands on the same slot every time.
+    Reset();
+    TimerWheel_Start(A, WHEEL_SLOTS, WHEEL_SLOTS);
+    Tick(WHEEL_SLOTS * 10);
+    CHECK((countA == 10) && (lastA == WHEEL_SLOTS * 10));
+
+    // A callback can cancel a timer due on the same tick before it fires.
+    Reset();
+    countDE = 0;
+    handleD = TimerWheel_Start(D, 4, 0);
+    handleE = TimerWheel_Start(E, 4 + WHEEL_SLOTS, 4); // same slot, a turn later
+    Tick(4);
+    CHECK((countDE == 1) && (TimerWheel_Active() == 0));
+    countDE = 0;
+    handleD = TimerWheel_Start(D, 4, 4);
+    handleE = TimerWheel_Start(E, 4, 4);
+    Tick(4);
+    CHECK((countDE == 1) && (TimerWheel_Active() == 1)); // the one that fired carries on
+    Tick(8);
+    CHECK(countDE == 3);
+
+    // A callback can cancel its own periodic timer.
+    Reset();
+    handleSelf = TimerWheel_Start(CancelSelf, 2, 2);
+    Tick(2);
+    CHECK(!TimerWheel_Pending(handleSelf) && (TimerWheel_Active() == 0));
+
+    // A callback can start a timer, and that timer counts from the tick it was started on.
+    Reset();
+    TimerWheel_Start(Restart, 6, 0);
+    Tick(6);
+    CHECK(TimerWheel_Pending(handleC) && (countA == 0));
+    Tick(3);
+    CHECK((countA == 1) && (firstA == 9));
+    return Test_Done("TestTimerWheel");
+}
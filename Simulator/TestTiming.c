@@ -0,0 +1,97 @@
+/* TestTiming.c
+ * Host test that the integer timings in the motion layer match the
+ * floating-point expressions they replaced: the delays take the time they
+ * ask for, the Simple moves hold their duty for time * 10ms, and the
+ * crossing speeds are the same numbers as MOVE_SPEED*1.15.
+ */
+
+#include "msp.h"
+#include "Simulator.h"
+#include "MotionProfile.h"
+#include "Motor.h"
+#include "Clock.h"
+#include "Timebase.h"
+#include "TimerAs.h"
+#define state testState // main.c has the real one
+#include "Globals.c"
+#undef state
+#include "Test.h"
+
+#define PWM_SCALE 8 // the old software PWM's periods per 10ms
+
+static uint32_t onTicks; // 1ms ticks seen with either motor driven
+static uint32_t offTicks; // and with both off
+
+// Samples the motor outputs every 1ms on a software timer.
+static void Sample(void)
+{
+    if (TIMER_A0->CCR[3] || TIMER_A0->CCR[4])
+    {
+        onTicks++;
+    }
+    else
+    {
+        offTicks++;
+    }
+}
+
+// Returns the simulated time "delay" takes, in us.
+static uint64_t Time(void (*delay)(uint32_t), uint32_t n)
+{
+    uint64_t start = Sim_Now;
+    (*delay)(n);
+    return Sim_Now - start;
+}
+
+int main(void)
+{
+    uint32_t n;
+    Sim_Setup();
+    Timebase_Init();
+    Motor_Init();
+    TimerA1_Init();
+
+    // The delays measure on the timebase; each Timer32 read in the simulator costs 1us.
+    for (n = 1; n <= 1000; n *= 10)
+    {
+        uint64_t us = Time(Clock_Delay1us, n);
+        CHECK((us >= n) && (us <= n + 2));
+        us = Time(Clock_Delay1ms, n);
+        CHECK((us >= 1000 * n) && (us <= 1000 * n + 2));
+    }
+
+    // Each Simple move drives for time * 10ms and stops.
+    void (*moves[])(uint16_t, uint32_t) = { Motor_ForwardSimple, Motor_BackwardSimple, Motor_LeftSimple, Motor_RightSimple };
+    uint16_t sampler = SoftTimer_Start(Sample, 1, 1);
+    for (n = 0; n < 4; n++)
+    {
+        onTicks = 0;
+        offTicks = 0;
+        uint64_t us = Sim_Now;
+        (*moves[n])(CROSSING_SPEED * 10, 4);
+        us = Sim_Now - us;
+        CHECK((us >= 40000) && (us <= 40002));
+        CHECK((onTicks >= 39) && (onTicks <= 40));
+        CHECK(offTicks <= 1);
+        CHECK((TIMER_A0->CCR[3] == 0) && (TIMER_A0->CCR[4] == 0));
+        CHECK(!(P3->OUT & 0xC0)); // both drivers asleep afterwards
+    }
+    SoftTimer_Cancel(sampler);
+
+    // The old software PWM had a 6000us period, on for duty * 48 / PWM_SCALE / 10 us of it, in float.
+    // The compare value gives the same time on, give or take the 1us the float truncated away.
+    for (n = 100; n <= 9900; n += 100)
+    {
+        int32_t on = 1.0f * n / 10000 * 48 / PWM_SCALE * 1000;
+        Motor_SetDuty(n, n);
+        int32_t error = TIMER_A0->CCR[4] * 6000 / 10000 - on;
+        CHECK((error >= 0) && (error <= 1));
+    }
+    Motor_StopSimple();
+
+    // The crossing speeds fold to the integers the doubles truncated to.
+    CHECK(CROSSING_SPEED == (int16_t)(MOVE_SPEED * 1.15));
+    CHECK(SOLUTION_CROSSING_SPEED == (int16_t)(SOLUTION_SPEED * 1.15));
+    CHECK(4000 * 115 / 100 == (uint16_t)(4000 * 1.15)); // the duty main.c passed before speeds were in mm/s
+    return Test_Done("TestTiming");
+}
@@ -0,0 +1,101 @@
+/* Track.c
+ * The floor the simulated robot drives on: a bitmap with 1 pixel per mm,
+ * where 0 is white and 255 is black tape. Either a built-in oval or a
+ * binary PGM (P5) image loaded from disk.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "Simulator.h"
+
+#define OVAL_STRAIGHT 1000 // length of each straight of the built-in oval, in mm
+#define OVAL_RADIUS 300 // radius of each end of the built-in oval, in mm
+#define LINE_WIDTH 19 // electrical tape, in mm
+#define MARGIN 200 // white border around the built-in oval, in mm
+
+static uint8_t *pixels; // row-major, row 0 is y = 0
+static int width, height;
+
+// Loads a binary PGM image as the track. Dark pixels are the line.
+// Returns 0 on success.
+int Track_Load(const char *path)
+{
+    FILE *f = fopen(path, "rb");
+    int maxval;
+    if (!f)
+    {
+        return -1;
+    }
+    if (fscanf(f, "P5 %d %d %d", &width, &height, &maxval) != 3 || maxval != 255)
+    {
+        fclose(f);
+        return -1;
+    }
+    fgetc(f); // the single whitespace after the header
+    pixels = malloc((size_t)width * height);
+    if (fread(pixels, 1, (size_t)width * height, f) != (size_t)width * height)
+    {
+        fclose(f);
+        return -1;
+    }
+    fclose(f);
+    int i;
+    for (i = 0; i < width * height; i++)
+    {
+        pixels[i] = 255 - pixels[i]; // PGM stores brightness; the track stores darkness
+    }
+    return 0;
+}
+
+// Draws the built-in oval and returns a starting pose on its bottom straight, facing +x.
+void Track_Default(double *x, double *y, double *heading)
+{
+    width = OVAL_STRAIGHT + 2 * OVAL_RADIUS + 2 * MARGIN;
+    height = 2 * OVAL_RADIUS + 2 * MARGIN;
+    pixels = calloc((size_t)width * height, 1);
+    double cx = width / 2.0, cy = height / 2.0;
+    int px, py;
+    for (py = 0; py < height; py++)
+    {
+        for (px = 0; px < width; px++)
+        {
+            double dx = px + 0.5 - cx, dy = py + 0.5 - cy, d;
+            if (fabs(dx) <= OVAL_STRAIGHT / 2.0) // beside a straight
+            {
+                d = fabs(fabs(dy) - OVAL_RADIUS);
+            }
+            else // around an end
+            {
+                double ex = fabs(dx) - OVAL_STRAIGHT / 2.0;
+                d = fabs(sqrt(ex * ex + dy * dy) - OVAL_RADIUS);
+            }
+            if (d <= LINE_WIDTH / 2.0)
+            {
+                pixels[py * width + px] = 255;
+            }
+        }
+    }
+    *x = cx - OVAL_STRAIGHT / 4.0;
+    *y = cy - OVAL_RADIUS;
+    *heading = 0;
+}
+
+// Returns how much of a 3x3mm spot centered on (x, y) is covered by the line, from 0 to 1.
+// Anything off the bitmap is white.
+double Track_Darkness(double x, double y)
+{
+    int sum = 0, dx, dy;
+    for (dy = -1; dy <= 1; dy++)
+    {
+        for (dx = -1; dx <= 1; dx++)
+        {
+            int px = (int)floor(x) + dx, py = (int)floor(y) + dy;
+            if ((px >= 0) && (px < width) && (py >= 0) && (py < height))
+            {
+                sum += pixels[py * width + px];
+            }
+        }
+    }
+    return sum / (9 * 255.0);
+}
@@ -0,0 +1,34 @@
+#!/bin/sh
+# Builds the host simulator as ./sim in the current directory, and each host
+# test Simulator/Test*.c as ./Test* (run them all with Simulator/test.sh).
+# The firmware sources are compiled unchanged against Simulator/msp.h;
+# Flash.c is replaced by Simulator/Flash.c.
+ROOT=$(cd "$(dirname "$0")/.." && pwd)
+FIRMWARE="Bumpers.c Buttons.c Clock.c Dma.c Encoder.c Idle.c LineSensor.c LineTable.c Junction.c LineTurn.c Maze.c Motion.c MotionProfile.c Motor.c OnBoardLEDs.c PID.c Probe.c Scheduler.c Store.c SysTick.c Telemetry.c Timebase.c TimerAs.c TimerWheel.c"
+CFLAGS="-std=gnu99 -fgnu89-inline -fcommon -O2 -Wall -Wno-main -I$ROOT/Simulator -I$ROOT"
+OBJ=$(mktemp -d)
+set -e
+gcc -O2 -Wall -o "$OBJ/GenLineTable" "$ROOT/Tools/GenLineTable.c"
+"$OBJ/GenLineTable" table "$ROOT/Tools/LineRules.txt" > "$OBJ/LineTable.c"
+if ! cmp -s "$OBJ/LineTable.c" "$ROOT/LineTable.c"; then
+    echo "LineTable.c doesn't match Tools/LineRules.txt; regenerate it (see Tools/GenLineTable.c)" >&2
+    rm -rf "$OBJ"
+    exit 1
+fi
+for f in $FIRMWARE; do
+    gcc $CFLAGS -c "$ROOT/$f" -o "$OBJ/${f%.c}.o"
+done
+gcc $CFLAGS -Dmain=Firmware_Main -c "$ROOT/main.c" -o "$OBJ/main.o"
+gcc $CFLAGS -c "$ROOT/Simulator/Simulator.c" -o "$OBJ/Simulator.o"
+gcc $CFLAGS -c "$ROOT/Simulator/Track.c" -o "$OBJ/Track.o"
+gcc $CFLAGS -c "$ROOT/Simulator/Flash.c" -o "$OBJ/Flash.o"
+gcc -o sim "$OBJ"/*.o -lm
+# The tests link the same objects, with the simulator's main renamed so the test's own main runs instead.
+mkdir "$OBJ/test"
+gcc $CFLAGS -Dmain=Sim_Main -c "$ROOT/Simulator/Simulator.c" -o "$OBJ/test/Simulator.o"
+LINK=$(ls "$OBJ"/*.o | grep -v '/Simulator\.o$')
+for t in "$ROOT"/Simulator/Test*.c; do
+    [ -e "$t" ] || continue
+    gcc $CFLAGS -pthread -o "$(basename "${t%.c}")" "$t" $LINK "$OBJ/test/Simulator.o" -lm
+done
+rm -rf "$OBJ"
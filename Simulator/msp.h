@@ -0,0 +1,165 @@
+/* msp.h (Simulator)
+ * Host stand-in for TI's msp.h. Each peripheral the firmware touches is
+ * a plain struct in RAM with the same register names as the real device
+ * header, so the firmware sources compile unchanged on Linux. Simulator.c
+ * reads and writes these structs to model the hardware.
+ */
+
+#ifndef SIM_MSP_H
+#define SIM_MSP_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Digital I/O port (P1 to P10 and PJ).
+typedef struct
+{
+    volatile uint8_t IN, OUT, DIR, REN, DS, SEL0, SEL1, SELC, IES, IE, IFG;
+    volatile uint16_t IV;
+} DIO_PORT_Type;
+extern DIO_PORT_Type Sim_Port[12];
+#define P1 (&Sim_Port[1])
+#define P2 (&Sim_Port[2])
+#define P3 (&Sim_Port[3])
+#define P4 (&Sim_Port[4])
+#define P5 (&Sim_Port[5])
+#define P6 (&Sim_Port[6])
+#define P7 (&Sim_Port[7])
+#define P8 (&Sim_Port[8])
+#define P9 (&Sim_Port[9])
+#define P10 (&Sim_Port[10])
+#define PJ (&Sim_Port[11])
+
+// Timer_A (TIMER_A0 to TIMER_A3).
+typedef struct
+{
+    volatile uint16_t CTL, CCTL[7], R, CCR[7], EX0, IV;
+} Timer_A_Type;
+extern Timer_A_Type Sim_TimerA[4];
+#define TIMER_A0 (&Sim_TimerA[0])
+#define TIMER_A1 (&Sim_TimerA[1])
+#define TIMER_A2 (&Sim_TimerA[2])
+#define TIMER_A3 (&Sim_TimerA[3])
+
+// Core peripherals.
+typedef struct
+{
+    volatile uint32_t CTRL, LOAD, VAL, CALIB;
+} SysTick_Type;
+extern SysTick_Type Sim_SysTick;
+#define SysTick (&Sim_SysTick)
+
+typedef struct
+{
+    volatile uint32_t ISER[8], ICER[8], ISPR[8], ICPR[8], IABR[8];
+    volatile uint8_t IP[240];
+} NVIC_Type;
+extern NVIC_Type Sim_NVIC;
+#define NVIC (&Sim_NVIC)
+
+typedef struct
+{
+    volatile uint32_t CPUID, ICSR, VTOR, AIRCR, SCR, CCR;
+    volatile uint8_t SHP[12];
+} SCB_Type;
+extern SCB_Type Sim_SCB;
+#define SCB (&Sim_SCB)
+
+// Timer32. Reading TIMER32_1 lets 1us of simulated time pass, so firmware that
+// busy-waits on the timebase makes progress.
+typedef struct
+{
+    volatile uint32_t LOAD, VALUE, CONTROL, INTCLR, RIS, MIS, BGLOAD;
+} Timer32_Type;
+Timer32_Type *Sim_Timer32(void);
+#define TIMER32_1 (Sim_Timer32())
+
+// Power, clock and flash control. Clock_Init48MHz finds them idle and gives up, which is harmless here.
+typedef struct
+{
+    volatile uint32_t CTL0, CTL1, IE, IFG, CLRIFG;
+} PCM_Type;
+extern PCM_Type Sim_PCM;
+#define PCM (&Sim_PCM)
+
+typedef struct
+{
+    volatile uint32_t KEY, CTL0, CTL1, CTL2, CTL3, CLKEN, STAT, IE, IFG, CLRIFG, SETIFG;
+} CS_Type;
+extern CS_Type Sim_CS;
+#define CS (&Sim_CS)
+
+typedef struct
+{
+    volatile uint32_t POWER_STAT, BANK0_RDCTL, BANK1_RDCTL;
+} FLCTL_Type;
+extern FLCTL_Type Sim_FLCTL;
+#define FLCTL (&Sim_FLCTL)
+#define FLCTL_BANK0_RDCTL_WAIT_2 0x00002000
+#define FLCTL_BANK1_RDCTL_WAIT_2 0x00002000
+
+// RTC_C. Only the prescalers (PS, counting BCLK at 32768Hz) and the RT1PS interval interrupt are modeled.
+typedef struct
+{
+    volatile uint16_t CTL0, CTL13, OCAL, TCMP, PS0CTL, PS1CTL, PS, IV, TIM0, TIM1, DATE, YEAR, AMINHR, ADOWDAY,
+            BIN2BCD, BCD2BIN;
+} RTC_C_Type;
+extern RTC_C_Type Sim_RTC_C;
+#define RTC_C (&Sim_RTC_C)
+
+// eUSCI_A0 as a UART, and the uDMA channel feeding it. CTLBASE holds a host pointer here, so the
+// firmware stores the control table's address as a uintptr_t (32 bits on the device).
+typedef struct
+{
+    volatile uint16_t CTLW0, CTLW1, BRW, MCTLW, STATW, RXBUF, TXBUF, ABCTL, IRCTL, IE, IFG, IV;
+} EUSCI_A_Type;
+extern EUSCI_A_Type Sim_EUSCI_A0;
+#define EUSCI_A0 (&Sim_EUSCI_A0)
+
+typedef struct
+{
+    volatile uint32_t STAT, CFG;
+    volatile uintptr_t CTLBASE;
+    volatile uint32_t ALTBASE, WAITSTAT, SWREQ, USEBURSTSET, USEBURSTCLR, REQMASKSET, REQMASKCLR,
+            ENASET, ENACLR, ALTSET, ALTCLR, PRIOSET, PRIOCLR, ERRCLR;
+} DMA_Control_Type;
+extern DMA_Control_Type Sim_DMA_Control;
+#define DMA_Control (&Sim_DMA_Control)
+
+typedef struct
+{
+    volatile uint32_t DEVICE_CFG, SW_CHTRIG, CH_SRCCFG[32], INT1_SRCCFG, INT2_SRCCFG, INT3_SRCCFG,
+            INT0_SRCFLG, INT0_CLRFLG;
+} DMA_Channel_Type;
+extern DMA_Channel_Type Sim_DMA_Channel;
+#define DMA_Channel (&Sim_DMA_Channel)
+
+// The DWT cycle counter follows the host's monotonic clock, scaled to 48MHz,
+// so the timing probes measure how long the firmware really takes on the host.
+typedef struct
+{
+    volatile uint32_t CTRL, CYCCNT;
+} DWT_Type;
+DWT_Type *Sim_DWT(void);
+#define DWT (Sim_DWT())
+
+typedef struct
+{
+    volatile uint32_t DEMCR;
+} CoreDebug_Type;
+extern CoreDebug_Type Sim_CoreDebug;
+#define CoreDebug (&Sim_CoreDebug)
+
+typedef struct
+{
+    volatile uint16_t CTL;
+} WDT_A_Type;
+extern WDT_A_Type Sim_WDT_A;
+#define WDT_A (&Sim_WDT_A)
+#define WDT_A_CTL_PW 0x5A00
+#define WDT_A_CTL_HOLD 0x0080
+
+// CMSIS memory barrier (Ring.h). A full host barrier, so Ring.h also holds up between host threads.
+#define __DMB() __sync_synchronize()
+
+#endif
@@ -0,0 +1,16 @@
+#!/bin/sh
+# Builds the simulator and the host tests (Simulator/Test*.c) in a scratch directory and runs every test.
+# Exits with 1 if any test failed.
+ROOT=$(cd "$(dirname "$0")/.." && pwd)
+DIR=$(mktemp -d)
+cd "$DIR" || exit 1
+if ! "$ROOT/Simulator/build.sh"; then
+    rm -rf "$DIR"
+    exit 1
+fi
+STATUS=0
+for t in Test*; do
+    ./"$t" || STATUS=1
+done
+cd / && rm -rf "$DIR"
+exit $STATUS
@@ -0,0 +1,230 @@
+
+#include "msp.h"
+#include "Flash.h"
+#include "Store.h"
+
+// A small key/value store in the two flash sectors of Flash.h. Records are appended to the active
+// sector, so a key can be rewritten many times before anything is erased; when the sector fills,
+// the latest record of every key is copied into the other sector, which then takes over. The two
+// sectors take turns, so each is erased only once per two sectors' worth of writes.
+//
+// A sector starts with a header: STORE_MAGIC, then a sequence number that goes up by one at every
+// changeover, so the newer of two valid sectors wins. The header is programmed last, so a sector
+// whose copy was cut short by a power failure is ignored. Each record is a header word
+//     key (bits 0-7) | length in bytes (bits 8-15) | CRC-16 of key, length and data (bits 16-31)
+// followed by the data, padded to whole words. A record with a bad CRC (it was being written when
+// the power went) is skipped over.
+#define STORE_MAGIC 0x31545352 // "RST1"
+#define FIRST_RECORD 2 // word index of the first record, after the sector header
+#define NO_RECORD 0 // Find's "not found"; never a record index since the header is there
+
+static uint8_t active; // the sector records are read from and appended to
+static uint16_t end; // word index of the free space in the active sector
+
+// Returns the words taken by "length" bytes of data.
+static uint16_t Words(uint8_t length)
+{
+    return (length + 3) / 4;
+}
+
+// Returns byte i of the data of the record whose header is at "record".
+static uint8_t DataByte(const uint32_t *record, uint8_t i)
+{
+    return record[1 + i / 4] >> ((i & 3) * 8);
+}
+
+// Adds one byte to a CRC-16-CCITT (polynomial 0x1021).
+static uint16_t Crc(uint16_t crc, uint8_t byte)
+{
+    uint8_t bit;
+    crc ^= byte << 8;
+    for (bit = 0; bit < 8; bit++)
+    {
+        crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+    }
+    return crc;
+}
+
+// Returns the CRC a record header should carry for "key", "length" and its data, which is read
+// from the record in flash if "record" isn't 0, otherwise from "data".
+static uint16_t RecordCrc(uint8_t key, uint8_t length, const uint32_t *record, const uint8_t *data)
+{
+    uint16_t crc = Crc(Crc(0xFFFF, key), length);
+    uint8_t i;
+    for (i = 0; i < length; i++)
+    {
+        crc = Crc(crc, record ? DataByte(record, i) : data[i]);
+    }
+    return crc;
+}
+
+// Returns 1 if the record at "record" has a good CRC.
+static uint8_t Valid(const uint32_t *record)
+{
+    uint32_t header = *record;
+    return (header >> 16) == RecordCrc(header, header >> 8, record, 0);
+}
+
+// Returns the word index after the last record in "sector".
+static uint16_t End(uint8_t sector)
+{
+    const uint32_t *words = Flash_Sector(sector);
+    uint16_t i = FIRST_RECORD;
+    while ((i < FLASH_SECTOR_WORDS) && (words[i] != FLASH_ERASED))
+    {
+        uint16_t next = i + 1 + Words(words[i] >> 8);
+        if (next > FLASH_SECTOR_WORDS) // a header mangled by a power failure; nothing after it can be trusted
+        {
+            break;
+        }
+        i = next;
+    }
+    return i;
+}
+
+// Returns the index of the latest good record for "key" in the active sector, or NO_RECORD.
+static uint16_t Find(uint8_t key)
+{
+    const uint32_t *words = Flash_Sector(active);
+    uint16_t i, found = NO_RECORD;
+    for (i = FIRST_RECORD; i < end; i += 1 + Words(words[i] >> 8))
+    {
+        if (((words[i] & 0xFF) == key) && Valid(&words[i]))
+        {
+            found = i;
+        }
+    }
+    return found;
+}
+
+// Programs a record into "sector" at word "at": the header first, so a cut-short record is
+// recognisably bad, then the data. Returns 1 if every word reads back as written.
+static uint8_t Put(uint8_t sector, uint16_t at, uint8_t key, const uint8_t *data, uint8_t length)
+{
+    uint16_t crc = RecordCrc(key, length, 0, data);
+    uint8_t ok = Flash_Program(sector, at, key | ((uint32_t)length << 8) | ((uint32_t)crc << 16));
+    uint8_t i;
+    for (i = 0; i < length; i += 4)
+    {
+        uint32_t word = FLASH_ERASED;
+        uint8_t j;
+        for (j = 0; (j < 4) && (i + j < length); j++)
+        {
+            word &= ~(0xFFul << (j * 8)) | ((uint32_t)data[i + j] << (j * 8));
+        }
+        ok &= Flash_Program(sector, at + 1 + i / 4, word);
+    }
+    return ok;
+}
+
+// Copies the latest record of every key but "skip" into the other sector, adds the new record
+// for "skip", and makes that sector the active one. Returns 1 if it all fitted and programmed.
+static uint8_t Changeover(uint8_t skip, const uint8_t *data, uint8_t length)
+{
+    const uint32_t *from = Flash_Sector(active);
+    uint8_t to = !active;
+    uint16_t i, at = FIRST_RECORD;
+    uint8_t ok = Flash_Erase(to);
+    for (i = FIRST_RECORD; i < end; i += 1 + Words(from[i] >> 8))
+    {
+        uint8_t key = from[i] & 0xFF;
+        uint8_t size = from[i] >> 8;
+        if ((key != skip) && (Find(key) == i))
+        {
+            uint16_t j;
+            for (j = 0; j < 1 + Words(size); j++) // header and data, word for word
+            {
+                ok &= Flash_Program(to, at + j, from[i + j]);
+            }
+            at += j;
+        }
+    }
+    if (at + 1 + Words(length) > FLASH_SECTOR_WORDS)
+    {
+        return 0; // the old sector is still intact and active
+    }
+    ok &= Put(to, at, skip, data, length);
+    if (!ok)
+    {
+        return 0;
+    }
+    Flash_Program(to, 1, from[1] + 1); // the header makes the new sector count
+    Flash_Program(to, 0, STORE_MAGIC);
+    active = to;
+    end = at + 1 + Words(length);
+    return 1;
+}
+
+// Finds the active sector, setting up the first one if neither has been used.
+void Store_Init(void)
+{
+    const uint32_t *a = Flash_Sector(0), *b = Flash_Sector(1);
+    uint8_t aValid = (a[0] == STORE_MAGIC), bValid = (b[0] == STORE_MAGIC);
+    if (aValid && bValid)
+    {
+        active = ((int32_t)(b[1] - a[1]) > 0); // the later one; the other was being erased
+    }
+    else if (aValid || bValid)
+    {
+        active = bValid;
+    }
+    else // a new chip
+    {
+        active = 0;
+        Flash_Erase(0);
+        Flash_Program(0, 1, 0);
+        Flash_Program(0, 0, STORE_MAGIC);
+    }
+    end = End(active);
+}
+
+// Copies the record for "key" into "data" if there is one of exactly "length" bytes,
+// so a record written for an older layout of a struct is ignored.
+// Returns 1 if "data" was filled in, 0 if it was left alone.
+uint8_t Store_Read(uint8_t key, void *data, uint8_t length)
+{
+    uint16_t at = Find(key);
+    const uint32_t *record = &Flash_Sector(active)[at];
+    uint8_t i;
+    if ((at == NO_RECORD) || (((*record >> 8) & 0xFF) != length))
+    {
+        return 0;
+    }
+    for (i = 0; i < length; i++)
+    {
+        ((uint8_t *)data)[i] = DataByte(record, i);
+    }
+    return 1;
+}
+
+// Stores "length" bytes of "data" under "key". Does nothing if that is what is stored already.
+// Blocks while flash is programmed: about 50us a word, plus an erase and a copy (tens of ms)
+// whenever the active sector fills up. Returns 1 if the record was stored.
+uint8_t Store_Write(uint8_t key, const void *data, uint8_t length)
+{
+    const uint8_t *bytes = data;
+    uint16_t at = Find(key);
+    if (at != NO_RECORD)
+    {
+        const uint32_t *record = &Flash_Sector(active)[at];
+        uint8_t i = 0;
+        if (((*record >> 8) & 0xFF) == length)
+        {
+            while ((i < length) && (DataByte(record, i) == bytes[i]))
+            {
+                i++;
+            }
+            if (i == length)
+            {
+                return 1;
+            }
+        }
+    }
+    if (end + 1 + Words(length) > FLASH_SECTOR_WORDS)
+    {
+        return Changeover(key, bytes, length);
+    }
+    uint8_t ok = Put(active, end, key, bytes, length);
+    end += 1 + Words(length);
+    return ok;
+}
@@ -0,0 +1,17 @@
+#ifndef STORE_H
+#define STORE_H
+
+// What the store holds. A key keeps the record last written to it.
+enum StoreKey
+{
+    STORE_ROUTE = 1, // the solved maze path (Maze.c)
+    STORE_CALIBRATION // line sensor calibration
+};
+
+#define STORE_MAX_LENGTH 255 // bytes in one record
+
+void Store_Init(void);
+uint8_t Store_Read(uint8_t key, void *data, uint8_t length);
+uint8_t Store_Write(uint8_t key, const void *data, uint8_t length);
+
+#endif
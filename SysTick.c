@@ -1,29 +1,48 @@
 
 #include "msp.h"
 #include "SysTick.h"
-#include "Globals.c"
-#include "LineSensor.h"
+#include "Scheduler.h"
+#include "Probe.h"
+#include "RamFunc.h"
 
 //#define SysTickInterval 0x00927C00 // 0.2 sec
 //#define SysTickInterval 0x00493E00 // 0.1 sec
 //#define SysTickInterval 0x00249F00 // 0.05 sec
-#define SysTickInterval 0x00124F80 // 0.025 sec
+//#define SysTickInterval 0x00124F80 // 0.025 sec
+//#define SysTickInterval 0x0003A980 // 0.005 sec
+#define SysTickInterval 0x0000BB80 // 0.001 sec (the scheduler tick)
+#define MAX_TICKS 300 // longest SysTick period, in ticks; the 24-bit counter holds up to 349
+
+// SysTick is tickless: rather than interrupting every tick, each period is stretched to end on the next
+// tick that releases a task. LOAD only takes effect when the counter wraps, so the handler always
+// programs the period after the one that has just started.
+static volatile uint16_t runningTicks = 1; // ticks in the period being counted now
+static volatile uint16_t loadedTicks = 1; // ticks in LOAD, the period after that
 
 // Initializes SysTick to send an interrupt every SysTickInterval clock cycles, and starts SysTick.
 void SysTick_Init(void)
 {
-    SysTick->LOAD = SysTickInterval; // load with the interval we want
+    SysTick_Restart(); // one tick per period until the handler knows better
     //SysTick->CTRL = 0x00000005; // enable SysTick with no interrupts
     SysTick->CTRL = 0x7; // enable SysTick with interrupts
     SCB->SHP[11] = 4 << 5; // priority 4
 }
 
 // Called every time SysTick sends an interrupt.
-void SysTick_Handler()
+RAMFUNC void SysTick_Handler()
 {
+    PROBE_BEGIN(PROBE_SYSTICK);
     // SysTick automatically acknowledges (resets) the interrupt flag
-    lineSensors = LineSensor_Read(); // read the line sensor
-    SysTick_Restart(); // reload SysTick
+    uint16_t ended = runningTicks;
+    runningTicks = loadedTicks; // the counter reloaded from LOAD as it wrapped
+    Scheduler_Tick(ended); // release the tasks that are due; they run in main
+    loadedTicks = Scheduler_NextRelease(runningTicks); // from the end of the period just started to the release after it
+    if (loadedTicks > MAX_TICKS)
+    {
+        loadedTicks = MAX_TICKS;
+    }
+    SysTick->LOAD = loadedTicks * (SysTickInterval + 1) - 1; // a tick is LOAD + 1 counts
+    PROBE_END(PROBE_SYSTICK);
 }
 
 // Disables the interrupt enable flag in SysTick.
@@ -38,8 +57,11 @@ inline void SysTick_EnableInterrupt()
     SysTick->CTRL = 0x7; // enable SysTick with interrupts
 }
 
-// Loads SysTickInterval into SysTick so it can restart.
+// Restarts SysTick from a whole tick, one tick per period, for when the scheduler has been restarted.
 inline void SysTick_Restart()
 {
     SysTick->LOAD = SysTickInterval; // load with the interval we want
+    SysTick->VAL = 0; // reload on the next count
+    runningTicks = 1;
+    loadedTicks = 1;
 }
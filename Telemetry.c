@@ -0,0 +1,132 @@
+
+#include "msp.h"
+#include "Telemetry.h"
+#include "Dma.h"
+#include "RamFunc.h"
+#include "Ring.h"
+
+// Streams telemetry frames out of eUSCI_A0 (P1.3 TX, the LaunchPad's USB serial port) at 115200 baud,
+// 8N1, so a frame takes 2.8ms. Telemetry_Send only packs the frame into a queue; DMA channel 0 feeds
+// the UART a byte at a time, and its done interrupt (DMA_INT1) starts the next queued frame, so the
+// control loop never waits on the UART. At 200 frames/s the port is about 55% busy.
+#define QUEUE 8 // frames that can wait to be sent; a power of two
+
+static uint8_t frames[QUEUE][TELEMETRY_FRAME_BYTES];
+static struct Ring queue = RING_INIT(QUEUE); // main fills it, DMA_INT1_IRQHandler drains it
+static uint8_t sending; // 1 while the DMA is sending the frame at the front of the queue (ISR only)
+static uint8_t sequence; // sequence number of the next frame (main only)
+
+// Initializes eUSCI_A0 as a UART and DMA channel 0 to feed it. Nothing is sent until Telemetry_Send.
+void Telemetry_Init(void)
+{
+    P1->SEL0 |= 0x0C; // P1.2 and P1.3 as UCA0RXD and UCA0TXD
+    P1->SEL1 &= ~0x0C;
+
+    EUSCI_A0->CTLW0 = 0x0001; // hold the eUSCI in reset while setting it up
+    EUSCI_A0->CTLW0 = 0x0081; // UART, 8N1, LSB first, SMCLK
+    EUSCI_A0->BRW = 6; // 12MHz / 115200 = 104.17 = 16 * 6.5: prescale 6,
+    EUSCI_A0->MCTLW = 0x2081; // first modulation 8 (half a bit of 16), second 0x20, oversampling on
+    EUSCI_A0->CTLW0 &= ~0x0001; // release it
+    EUSCI_A0->IE = 0; // the DMA watches UCTXIFG; no UART interrupts
+
+    Dma_Init();
+    DMA_Control->ALTCLR = 0x01; // channel 0 uses its primary structure,
+    DMA_Control->PRIOCLR = 0x01; // at default priority,
+    DMA_Control->USEBURSTCLR = 0x01; // for single requests too,
+    DMA_Control->REQMASKCLR = 0x01; // which aren't masked
+    DMA_Channel->CH_SRCCFG[0] = 1; // channel 0 is triggered by eUSCI_A0 TX
+    DMA_Channel->INT1_SRCCFG = 0x20; // channel 0 finishing raises DMA_INT1
+    NVIC->IP[33] = 0x60; // priority 3, the lowest in use
+    NVIC->ISER[1] = 0x00000002; // enable interrupt 33 (DMA_INT1) in NVIC
+}
+
+// Writes "value" into "at" as "n" little-endian bytes.
+static void Put(uint8_t *at, uint32_t value, uint8_t n)
+{
+    while (n--)
+    {
+        *at++ = value;
+        value >>= 8;
+    }
+}
+
+// Queues a frame to be sent and returns at once (it takes a few us). Returns 0 if the queue is full
+// and the frame was dropped; Telemetry_Overruns counts those. Call from main.
+uint8_t Telemetry_Send(const struct TelemetryFrame *frame)
+{
+    int16_t slot = Ring_Reserve(&queue);
+    if (slot < 0)
+    {
+        sequence++; // so the decoder sees the gap
+        return 0;
+    }
+    uint8_t *f = frames[slot];
+    uint8_t i, sum = 0;
+    f[0] = TELEMETRY_SYNC;
+    f[1] = sequence++;
+    Put(&f[2], frame->time, 4);
+    f[6] = frame->bits;
+    f[7] = frame->state;
+    for (i = 0; i < 8; i++)
+    {
+        f[8 + i] = (frame->times[i] >= 2550) ? 255 : frame->times[i] / 10;
+    }
+    Put(&f[16], frame->position, 2);
+    Put(&f[18], frame->leftDuty, 2);
+    Put(&f[20], frame->rightDuty, 2);
+    Put(&f[22], frame->leftSpeed, 2);
+    Put(&f[24], frame->rightSpeed, 2);
+    Put(&f[26], frame->leftTarget, 2);
+    Put(&f[28], frame->rightTarget, 2);
+    f[30] = (frame->junction & 0x7F) | (frame->crossing ? 0x80 : 0);
+    for (i = 0; i < TELEMETRY_FRAME_BYTES - 1; i++)
+    {
+        sum += f[i];
+    }
+    f[TELEMETRY_FRAME_BYTES - 1] = -sum;
+    Ring_Publish(&queue);
+    NVIC->ISPR[1] = 0x00000002; // run DMA_INT1_IRQHandler to start sending if the DMA is idle
+    return 1;
+}
+
+// Returns the number of frames dropped because the UART couldn't keep up.
+uint16_t Telemetry_Overruns(void)
+{
+    return queue.overruns;
+}
+
+// Returns 1 while frames are queued or still going out of the UART, which needs SMCLK until they're done.
+uint8_t Telemetry_Busy(void)
+{
+    return (Ring_Count(&queue) != 0) || (EUSCI_A0->STATW & 0x0001); // UCBUSY: the last byte is still shifting out
+}
+
+// Handles the DMA finishing a frame (or Telemetry_Send asking for a look): frees the frame that was
+// sent and starts the DMA on the next one.
+void DMA_INT1_IRQHandler(void)
+{
+    DMA_Channel->INT0_CLRFLG = 0x01; // acknowledge channel 0
+    if (DMA_Control->ENASET & 0x01) // still sending
+    {
+        return;
+    }
+    if (sending)
+    {
+        Ring_Pop(&queue);
+        sending = 0;
+    }
+    int16_t slot = Ring_Front(&queue);
+    if (slot < 0)
+    {
+        return;
+    }
+    dmaTable[0].srcEnd = &frames[slot][TELEMETRY_FRAME_BYTES - 1];
+    dmaTable[0].dstEnd = &EUSCI_A0->TXBUF;
+    dmaTable[0].control = 0xC0000000 // destination doesn't increment,
+            | ((uint32_t)(TELEMETRY_FRAME_BYTES - 1) << 4) // source steps a byte at a time, one byte per request,
+            | 0x1; // basic mode
+    sending = 1;
+    DMA_Control->ENASET = 0x01; // enable channel 0
+    EUSCI_A0->IFG &= ~0x0002; // an edge on UCTXIFG makes the first request
+    EUSCI_A0->IFG |= 0x0002;
+}
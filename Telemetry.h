@@ -0,0 +1,42 @@
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+// One control tick's worth of what the robot saw and did.
+struct TelemetryFrame
+{
+    uint32_t time; // us, when the line sensor sample was read
+    uint8_t bits; // line sensor pattern
+    uint16_t times[8]; // discharge time of each channel in us
+    int16_t position; // line position, -3500 to 3500
+    int16_t leftDuty, rightDuty; // -10000 to 10000
+    int16_t leftSpeed, rightSpeed; // measured, in mm/s
+    int16_t leftTarget, rightTarget; // speed setpoints, in mm/s
+    uint8_t state; // enum State
+    uint8_t junction; // enum JunctionType of the last junction event
+    uint8_t crossing; // 1 while driving blind over a junction
+};
+
+// On the wire, each frame is TELEMETRY_FRAME_BYTES bytes, little-endian:
+//   0      0xA5 (TELEMETRY_SYNC)
+//   1      sequence number, + 1 per frame queued (a gap means frames were dropped)
+//   2-5    time
+//   6      bits
+//   7      state
+//   8-15   times, in 10us units (saturating at 2550us), bit 0 first
+//   16-17  position
+//   18-21  leftDuty, rightDuty
+//   22-25  leftSpeed, rightSpeed
+//   26-29  leftTarget, rightTarget
+//   30     junction in bits 0-6, crossing in bit 7
+//   31     checksum: all 32 bytes add up to 0 (mod 256)
+// Tools/TelemetryDecode.c turns a capture of them into CSV.
+#define TELEMETRY_SYNC 0xA5
+#define TELEMETRY_FRAME_BYTES 32
+
+void Telemetry_Init(void);
+uint8_t Telemetry_Send(const struct TelemetryFrame *frame);
+uint16_t Telemetry_Overruns(void);
+uint8_t Telemetry_Busy(void);
+void DMA_INT1_IRQHandler(void);
+
+#endif
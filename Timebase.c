@@ -0,0 +1,57 @@
+
+#include "msp.h"
+#include "Timebase.h"
+#include "RamFunc.h"
+
+// Timer32_1 counts down from 0xFFFFFFFF and wraps forever, so ~VALUE counts up.
+// At 3 ticks per us, the tick count wraps every 23.8 minutes. All comparisons
+// below subtract tick counts, which stays correct across the wrap as long as
+// the interval being measured is shorter than half of that (about 11.9 minutes).
+
+// Starts Timer32_1 as a free-running 32-bit counter. Call after Clock_Init48MHz().
+void Timebase_Init(void)
+{
+    TIMER32_1->CONTROL = 0; // stop the timer
+    TIMER32_1->LOAD = 0xFFFFFFFF; // count through the whole 32-bit range
+    TIMER32_1->CONTROL = 0x00000086; // enable, free-running, no interrupt, prescale /16, 32-bit
+}
+
+// Returns the current time in ticks (TIMEBASE_TICKS_PER_US per microsecond).
+RAMFUNC uint32_t Timebase_Now(void)
+{
+    return ~TIMER32_1->VALUE;
+}
+
+// Returns the current time in microseconds.
+// This wraps every 23.8 minutes, not at 2^32, so use Timebase_Elapsed() to measure intervals.
+RAMFUNC uint32_t Timebase_NowUs(void)
+{
+    return Timebase_Now() / TIMEBASE_TICKS_PER_US;
+}
+
+// Returns the tick count "us" microseconds from now, for Timebase_Expired() and Timebase_WaitUntil().
+uint32_t Timebase_Deadline(uint32_t us)
+{
+    return Timebase_Now() + us * TIMEBASE_TICKS_PER_US;
+}
+
+// Returns 1 if "deadline" (from Timebase_Deadline) has passed. Never blocks.
+uint8_t Timebase_Expired(uint32_t deadline)
+{
+    return (int32_t)(Timebase_Now() - deadline) >= 0;
+}
+
+// Returns 1 if at least "us" microseconds have passed since "start" (from Timebase_Now). Never blocks.
+uint8_t Timebase_Elapsed(uint32_t start, uint32_t us)
+{
+    return (Timebase_Now() - start) >= us * TIMEBASE_TICKS_PER_US;
+}
+
+// Busy-waits until "deadline" (from Timebase_Deadline) has passed.
+// Successive waits on deadlines computed from each other don't accumulate drift.
+void Timebase_WaitUntil(uint32_t deadline)
+{
+    while (!Timebase_Expired(deadline))
+    {
+    }
+}
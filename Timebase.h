@@ -0,0 +1,9 @@
+#define TIMEBASE_TICKS_PER_US 3 // Timer32 runs from MCLK (48MHz) divided by 16
+
+void Timebase_Init(void);
+uint32_t Timebase_Now(void);
+uint32_t Timebase_NowUs(void);
+uint32_t Timebase_Deadline(uint32_t us);
+uint8_t Timebase_Expired(uint32_t deadline);
+uint8_t Timebase_Elapsed(uint32_t start, uint32_t us);
+void Timebase_WaitUntil(uint32_t deadline);
@@ -1,8 +1,9 @@
 /* TimerAs.c
- * This file contains code related to Timer A0, including
+ * This file contains code related to Timer A1, including
  * initialization, interrupt handling, starting, and stopping.
- * Timer A0 is used to blink the LEDs on the breadboard on
- * top of the robot.
+ * Timer A1 ticks every 1ms and drives the software timers in
+ * TimerWheel.c, so LED blinking, debouncing and timeouts all share
+ * one interrupt. (Timer A0 generates the motor PWM.)
  */
 
 /* Licensed under Simplified BSD license by Christopher Andrews.
@@ -68,66 +69,110 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include "msp.h"
 #include "TimerAs.h"
+#include "TimerWheel.h"
+#include "GenInterrupts.h"
+#include "Probe.h"
+#include "RamFunc.h"
 
-void (*PeriodicTask)(void); // the function to call when Timer A0 sends an interrupt
-uint8_t numTimes; // the number of times to call PeriodicTask upon interrupt
-uint16_t count; // the number of times the interrupt has been called. Used to only call the function every X interrupts
+static uint16_t blinkTimer = TIMERWHEEL_NONE; // the timer behind TimerA1_Start
+static void (*blinkTask)(void); // the function TimerA1_Start calls
+static uint8_t blinkTimes; // the number of calls left
 
-// Initializes Timer A0, but doesn't start it yet.
-void TimerA0_Init()
+// Initializes Timer A1 to tick every 1ms, but doesn't start it yet.
+// It only runs while at least one software timer is armed.
+void TimerA1_Init()
 {
-    TIMER_A0->CTL &= ~0x0030; // stop Timer A0
-    TIMER_A0->CTL = 0x0202; // compare causes interrupts, no I/O
-    TIMER_A0->CCTL[0] = 0x0010; // compare
-    //TIMER_A0->CCR[0] = (period-1); // compare match value
-    TIMER_A0->EX0 = 0x3; // configure for clock input divider /8
-    NVIC->IP[2] = (NVIC->IP[2] & 0xFFFFFF00) | 0x00000040; // priority 2
-    NVIC->ISER[0] = 0x00000100; // enable interrupt 8 in NVIC
-    //TIMER_A0->CTL |= 0x0014; // reset and start Timer A0
+    TIMER_A1->CTL &= ~0x0030; // stop Timer A1
+    TIMER_A1->CTL = 0x0280; // SMCLK, divide by 4, no I/O
+    TIMER_A1->CCTL[0] = 0x0010; // compare causes interrupts
+    TIMER_A1->CCR[0] = 999; // 1000 counts per tick
+    TIMER_A1->EX0 = 0x2; // divide by 3 more, for 12MHz / 12 = 1MHz
+    NVIC->IP[10] = 0x40; // priority 2
+    NVIC->ISER[0] = 0x00000400; // enable interrupt 10 in NVIC
+    TimerWheel_Init();
 }
 
-// Starts Timer A0 and sets it to:
-// Interrupt every 50 "period"s.
-// Interrupt only "times" number of times.
-// Call "task" when it interrupts.
+// Arms a software timer that calls "callback" "delay" ms from now, then every "period" ms
+// (0 for a one-shot timer). The callback runs in the Timer A1 interrupt, at priority 2.
+// The first call comes between delay - 1 and delay ms from now, since ticks are 1ms apart.
+// Returns a handle for SoftTimer_Cancel, or TIMERWHEEL_NONE if every timer is in use.
+uint16_t SoftTimer_Start(void (*callback)(void), uint16_t delay, uint16_t period)
+{
+    uint32_t sr = StartCritical();
+    uint16_t handle = TimerWheel_Start(callback, delay, period);
+    if ((handle != TIMERWHEEL_NONE) && !(TIMER_A1->CTL & 0x0030)) // the first timer wakes the tick up
+    {
+        TIMER_A1->CCTL[0] &= ~0x0001; // drop any stale interrupt
+        TIMER_A1->CTL |= 0x0014; // reset and start Timer A1 in up mode
+    }
+    EndCritical(sr);
+    return handle;
+}
+
+// Disarms a software timer. Returns 1 if it was armed, 0 if it had already expired or been cancelled.
+uint8_t SoftTimer_Cancel(uint16_t handle)
+{
+    uint32_t sr = StartCritical();
+    uint8_t armed = TimerWheel_Cancel(handle);
+    EndCritical(sr);
+    return armed;
+}
+
+// Returns 1 if the software timer is still armed.
+uint8_t SoftTimer_Pending(uint16_t handle)
+{
+    return TimerWheel_Pending(handle);
+}
+
+// Calls the TimerA1_Start task and disarms it after the last call.
+static void Blink(void)
+{
+    blinkTimes--;
+    if (blinkTimes == 0)
+    {
+        SoftTimer_Cancel(blinkTimer);
+    }
+    (*blinkTask)();
+}
+
+// Calls "task" every 50 "period"s, "times" times, on a software timer.
+// (Kept with its old units: 50 periods of Timer A1 at 3MHz is period / 60 ms.)
 //
-// task: Input. The function to call when Timer A0 interrupts.
-// period: Input. The time between each function call from Timer A0. Gets multiplied by 50 by only calling the function every 50 interrupts.
-// times: Input. The number of times to call that function before disabling Timer A0.
-void TimerA0_Start(void(*task)(void), uint16_t period, uint8_t times)
+// task: Input. The function to call.
+// period: Input. The time between each function call, in 1/3000 ms before the 50x.
+// times: Input. The number of times to call that function; 0 calls it no times and just stops the last task.
+void TimerA1_Start(void(*task)(void), uint16_t period, uint8_t times)
 {
-    PeriodicTask = task; // store the function to call when Timer A0 interrupts
-    numTimes = times; // store the number of times to call the function
-    TIMER_A0->CTL &= ~0x0030; // stop Timer A0
-    TIMER_A0->CCR[0] = period - 1; // the time between each interrupt
-    count = 0; // reset the number of interrupts received from Timer A0
-    TIMER_A0->CTL |= 0x0014; // reset and start Timer A0
+    TimerA1_Stop(); // only one of these at a time, like before
+    if (times == 0) // Blink would count down from 0 and call the task 255 times
+    {
+        return;
+    }
+    uint16_t ms = (period + 30) / 60;
+    if (ms == 0)
+    {
+        ms = 1;
+    }
+    blinkTask = task; // store the function to call
+    blinkTimes = times; // store the number of times to call the function
+    blinkTimer = SoftTimer_Start(Blink, ms, ms);
 }
 
-// Handles when Timer A0 interrupts.
-void TA0_0_IRQHandler()
+// Handles when Timer A1 interrupts: one tick of the software timers.
+RAMFUNC void TA1_0_IRQHandler()
 {
-    TIMER_A0->CCTL[0] &= ~0x0001; // acknowledge interrupt 0
-    count++; // increment the number of interrupts received from Timer A0
-    if (count == 50) // if we've reached the required number of interrupts to call a function
+    PROBE_BEGIN(PROBE_TIMER_ISR);
+    TIMER_A1->CCTL[0] &= ~0x0001; // acknowledge interrupt 0
+    TimerWheel_Tick();
+    if (TimerWheel_Active() == 0) // nothing left to count down, so stop ticking
     {
-        count = 0; // reset the dividing counter
-        (*PeriodicTask)(); // call the function necessary when Timer A0 interrupts
-        numTimes--; // decrement the number of times to call PeriodicTask
-
-        if (numTimes == 0) // if we shouldn't call the function anymore
-        {
-            TIMER_A0->CTL &= ~0x0030; // stop Timer A0
-        }
-        else
-        {
-            TIMER_A0->CTL |= 0x0014; // reset and start Timer A0
-        }
+        TIMER_A1->CTL &= ~0x0030; // stop Timer A1
     }
+    PROBE_END(PROBE_TIMER_ISR);
 }
 
-// Forces Timer A0 to stop.
-inline void TimerA0_Stop()
+// Stops the TimerA1_Start task. Other software timers keep running.
+void TimerA1_Stop()
 {
-    TIMER_A0->CTL &= ~0x0030; // stop Timer A0
+    SoftTimer_Cancel(blinkTimer);
 }
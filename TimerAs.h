@@ -30,7 +30,10 @@ THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
 OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
-void TimerA0_Init();
-void TimerA0_Start(void(*task)(void), uint16_t period, uint8_t times);
-void TA0_0_IRQHandler();
-void TimerA0_Stop();
+void TimerA1_Init();
+void TimerA1_Start(void(*task)(void), uint16_t period, uint8_t times);
+void TA1_0_IRQHandler();
+void TimerA1_Stop();
+uint16_t SoftTimer_Start(void (*callback)(void), uint16_t delay, uint16_t period);
+uint8_t SoftTimer_Cancel(uint16_t handle);
+uint8_t SoftTimer_Pending(uint16_t handle);
@@ -0,0 +1,211 @@
+/* TimerWheel.c
+ * This file contains a hashed timing wheel: many one-shot and periodic
+ * software timers counted down by a single periodic tick.
+ *
+ * Timers live in a fixed pool. Each armed timer sits in the wheel slot
+ * it expires in, on a doubly linked list, so starting and cancelling are
+ * O(1) and a tick only looks at one slot. A timer more than one turn of
+ * the wheel away carries the number of whole turns it still has to wait.
+ *
+ * Nothing here touches hardware, so the same file runs on the host. The
+ * caller provides the tick and any locking (see SoftTimer_* in TimerAs.c).
+ */
+
+#include <stdint.h>
+#include "TimerWheel.h"
+#include "RamFunc.h"
+
+#define WHEEL_SLOTS 32 // must be a power of two
+#define WHEEL_MASK (WHEEL_SLOTS - 1)
+#define EXPIRING WHEEL_SLOTS // extra list holding the timers that expire on the current tick
+#define POOL_SIZE 16 // at most 255 so an index fits in the low byte of a handle
+#define NIL 0xFF // end of a list
+
+struct Timer
+{
+    void (*callback)(void);
+    uint16_t period; // ticks between expiries, 0 for a one-shot timer
+    uint16_t rounds; // whole turns of the wheel left before it expires
+    uint8_t next, prev; // neighbours in the slot's list
+    uint8_t slot; // the list the timer is on, or NIL if it's free
+    uint8_t generation; // bumped on every free so stale handles don't match
+};
+
+static struct Timer pool[POOL_SIZE];
+static uint8_t lists[WHEEL_SLOTS + 1]; // first timer in each slot, plus the EXPIRING list
+static uint8_t freeList; // unused timers, linked through "next"
+static uint8_t cursor; // the slot of the latest tick
+static uint8_t active; // number of armed timers
+
+// Adds timer "i" to the front of "list".
+RAMFUNC static void Link(uint8_t i, uint8_t list)
+{
+    struct Timer *t = &pool[i];
+    t->slot = list;
+    t->prev = NIL;
+    t->next = lists[list];
+    if (t->next != NIL)
+    {
+        pool[t->next].prev = i;
+    }
+    lists[list] = i;
+}
+
+// Removes timer "i" from whatever list it is on.
+RAMFUNC static void Unlink(uint8_t i)
+{
+    struct Timer *t = &pool[i];
+    if (t->prev != NIL)
+    {
+        pool[t->prev].next = t->next;
+    }
+    else
+    {
+        lists[t->slot] = t->next;
+    }
+    if (t->next != NIL)
+    {
+        pool[t->next].prev = t->prev;
+    }
+}
+
+// Puts timer "i" in the slot "ticks" ticks from now (ticks >= 1).
+RAMFUNC static void Schedule(uint8_t i, uint16_t ticks)
+{
+    pool[i].rounds = (ticks - 1) / WHEEL_SLOTS;
+    Link(i, (cursor + ticks) & WHEEL_MASK);
+}
+
+// Returns timer "i" to the pool. Handles to it stop matching.
+RAMFUNC static void Free(uint8_t i)
+{
+    struct Timer *t = &pool[i];
+    t->slot = NIL;
+    t->generation++;
+    if (t->generation == 0) // 0 would let the handle equal TIMERWHEEL_NONE
+    {
+        t->generation = 1;
+    }
+    t->next = freeList;
+    freeList = i;
+    active--;
+}
+
+// Returns the index of the armed timer "handle" refers to, or NIL if it has expired or been cancelled.
+static uint8_t Lookup(uint16_t handle)
+{
+    uint8_t i = handle & 0xFF;
+    if ((i >= POOL_SIZE) || (pool[i].slot == NIL) || (pool[i].generation != (handle >> 8)))
+    {
+        return NIL;
+    }
+    return i;
+}
+
+// Empties the wheel. Any outstanding handles become invalid.
+void TimerWheel_Init(void)
+{
+    int i;
+    for (i = 0; i <= WHEEL_SLOTS; i++)
+    {
+        lists[i] = NIL;
+    }
+    freeList = NIL;
+    for (i = POOL_SIZE - 1; i >= 0; i--)
+    {
+        pool[i].slot = NIL;
+        pool[i].generation++;
+        if (pool[i].generation == 0)
+        {
+            pool[i].generation = 1;
+        }
+        pool[i].next = freeList;
+        freeList = i;
+    }
+    cursor = 0;
+    active = 0;
+}
+
+// Arms a timer that calls "callback" on the "delay"th tick from now, then every "period" ticks.
+// A period of 0 makes it a one-shot timer. A delay of 0 is treated as 1.
+// Returns a handle for TimerWheel_Cancel, or TIMERWHEEL_NONE if the pool is used up.
+uint16_t TimerWheel_Start(void (*callback)(void), uint16_t delay, uint16_t period)
+{
+    uint8_t i = freeList;
+    if (i == NIL)
+    {
+        return TIMERWHEEL_NONE;
+    }
+    freeList = pool[i].next;
+    active++;
+    pool[i].callback = callback;
+    pool[i].period = period;
+    Schedule(i, (delay == 0) ? 1 : delay);
+    return ((uint16_t)pool[i].generation << 8) | i;
+}
+
+// Disarms the timer "handle" refers to.
+// Returns 1 if it was armed, 0 if it had already expired or been cancelled.
+uint8_t TimerWheel_Cancel(uint16_t handle)
+{
+    uint8_t i = Lookup(handle);
+    if (i == NIL)
+    {
+        return 0;
+    }
+    Unlink(i);
+    Free(i);
+    return 1;
+}
+
+// Returns 1 if the timer "handle" refers to is still armed.
+uint8_t TimerWheel_Pending(uint16_t handle)
+{
+    return Lookup(handle) != NIL;
+}
+
+// Returns the number of armed timers, so the caller can stop the tick when there are none.
+RAMFUNC uint8_t TimerWheel_Active(void)
+{
+    return active;
+}
+
+// Advances the wheel by one tick and calls the callback of every timer that expires.
+// Callbacks may start and cancel timers, including their own.
+RAMFUNC void TimerWheel_Tick(void)
+{
+    cursor = (cursor + 1) & WHEEL_MASK;
+
+    // Move the timers that are due onto the EXPIRING list; the rest of the slot waits another turn.
+    uint8_t i = lists[cursor];
+    while (i != NIL)
+    {
+        uint8_t next = pool[i].next;
+        if (pool[i].rounds == 0)
+        {
+            Unlink(i);
+            Link(i, EXPIRING);
+        }
+        else
+        {
+            pool[i].rounds--;
+        }
+        i = next;
+    }
+
+    // Fire them one at a time. A callback cancelling a timer still on the list simply unlinks it.
+    while ((i = lists[EXPIRING]) != NIL)
+    {
+        void (*callback)(void) = pool[i].callback;
+        Unlink(i);
+        if (pool[i].period)
+        {
+            Schedule(i, pool[i].period);
+        }
+        else
+        {
+            Free(i);
+        }
+        callback();
+    }
+}
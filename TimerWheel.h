@@ -0,0 +1,12 @@
+/* TimerWheel.h
+ * This file contains function headers for TimerWheel.c.
+ */
+
+#define TIMERWHEEL_NONE 0 // a handle that never refers to a timer
+
+void TimerWheel_Init(void);
+uint16_t TimerWheel_Start(void (*callback)(void), uint16_t delay, uint16_t period);
+uint8_t TimerWheel_Cancel(uint16_t handle);
+uint8_t TimerWheel_Pending(uint16_t handle);
+uint8_t TimerWheel_Active(void);
+void TimerWheel_Tick(void);
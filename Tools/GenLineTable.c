@@ -0,0 +1,365 @@
+/* GenLineTable.c
+ * Host tool that compiles the line sensor rules (Tools/LineRules.txt) into
+ * the 256-entry classification table the firmware indexes with each raw
+ * sensor pattern, and prints the table for review.
+ *
+ * Build:  gcc -o GenLineTable Tools/GenLineTable.c
+ * Use:    ./GenLineTable table Tools/LineRules.txt > LineTable.c
+ *         ./GenLineTable dump Tools/LineRules.txt
+ *         ./GenLineTable diff old-rules.txt Tools/LineRules.txt
+ *
+ * "diff" lists only the patterns whose entry changes between two rule files,
+ * for example:
+ *         git show HEAD:Tools/LineRules.txt > /tmp/old.txt
+ *         ./GenLineTable diff /tmp/old.txt Tools/LineRules.txt
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_RULES 64
+#define POS_CENTROID 100000 // position keywords, outside the range of real positions
+#define POS_LARGEST 100001
+#define POS_HOLD 100002
+#define LINE_HOLD (-32768) // must match LineTable.h
+
+static const char *eventNames[] = { "follow", "lost", "intersection", "left-branch", "right-branch" };
+static const char *eventEnums[] = { "LINE_FOLLOW", "LINE_LOST", "LINE_INTERSECTION", "LINE_LEFT_BRANCH", "LINE_RIGHT_BRANCH" };
+#define NUM_EVENTS (sizeof(eventNames) / sizeof(eventNames[0]))
+
+struct Rule
+{
+    int line; // line number in the rule file
+    int split; // 1 for the "split" pattern
+    unsigned care, value; // pattern bits that must match, and what they must be
+    int event;
+    long position; // a position or one of the POS_ keywords
+    int confidence;
+};
+
+struct Entry
+{
+    int position;
+    int event;
+    int confidence;
+    int rule; // line number of the rule that produced it
+};
+
+// Weight of sensor bit i, matching LineSensor_Position: bit 7 = -3500, bit 0 = 3500.
+static int Weight(int bit)
+{
+    return 3500 - 1000 * bit;
+}
+
+// Returns the number of separate runs of 1s in pattern.
+static int Runs(unsigned pattern)
+{
+    int runs = 0, bit;
+    for (bit = 0; bit < 8; bit++)
+    {
+        if ((pattern >> bit & 1) && !(bit < 7 && (pattern >> (bit + 1) & 1)))
+        {
+            runs++;
+        }
+    }
+    return runs;
+}
+
+// Returns the middle of the black sensors in pattern (which must not be 0).
+static int Centroid(unsigned pattern)
+{
+    int bit, sum = 0, count = 0;
+    for (bit = 0; bit < 8; bit++)
+    {
+        if (pattern >> bit & 1)
+        {
+            sum += Weight(bit);
+            count++;
+        }
+    }
+    return sum / count;
+}
+
+// Returns pattern with every run of 1s but the longest cleared (the left-most wins a tie).
+static unsigned Largest(unsigned pattern)
+{
+    unsigned best = 0, run = 0;
+    int bit, bestLength = 0, length = 0;
+    for (bit = 7; bit >= -1; bit--)
+    {
+        if ((bit >= 0) && (pattern >> bit & 1))
+        {
+            run |= 1u << bit;
+            length++;
+        }
+        else
+        {
+            if (length > bestLength)
+            {
+                best = run;
+                bestLength = length;
+            }
+            run = 0;
+            length = 0;
+        }
+    }
+    return best;
+}
+
+// Reads the rule file at path into rules. Exits with a message on a syntax error.
+static int Load(const char *path, struct Rule *rules)
+{
+    FILE *f = fopen(path, "r");
+    char text[256];
+    int count = 0, line = 0;
+    if (!f)
+    {
+        fprintf(stderr, "can't open %s\n", path);
+        exit(1);
+    }
+    while (fgets(text, sizeof(text), f))
+    {
+        char pattern[32], event[32], position[32];
+        int confidence, i;
+        line++;
+        char *hash = strchr(text, '#');
+        if (hash)
+        {
+            *hash = 0;
+        }
+        int fields = sscanf(text, "%31s %31s %31s %d", pattern, event, position, &confidence);
+        if (fields <= 0)
+        {
+            continue; // blank or comment
+        }
+        if ((fields != 4) || (count == MAX_RULES))
+        {
+            fprintf(stderr, "%s:%d: expected: pattern event position confidence\n", path, line);
+            exit(1);
+        }
+        struct Rule *r = &rules[count];
+        memset(r, 0, sizeof(*r));
+        r->line = line;
+        if (!strcmp(pattern, "split"))
+        {
+            r->split = 1;
+        }
+        else if (strlen(pattern) == 8)
+        {
+            for (i = 0; i < 8; i++)
+            {
+                unsigned bit = 1u << (7 - i);
+                if (pattern[i] == '1')
+                {
+                    r->care |= bit;
+                    r->value |= bit;
+                }
+                else if (pattern[i] == '0')
+                {
+                    r->care |= bit;
+                }
+                else if (pattern[i] != 'x')
+                {
+                    break;
+                }
+            }
+            if (i < 8)
+            {
+                fprintf(stderr, "%s:%d: pattern must be 8 of 0, 1 and x\n", path, line);
+                exit(1);
+            }
+        }
+        else
+        {
+            fprintf(stderr, "%s:%d: pattern must be 8 of 0, 1 and x, or split\n", path, line);
+            exit(1);
+        }
+        for (r->event = 0; r->event < (int)NUM_EVENTS; r->event++)
+        {
+            if (!strcmp(event, eventNames[r->event]))
+            {
+                break;
+            }
+        }
+        if (r->event == NUM_EVENTS)
+        {
+            fprintf(stderr, "%s:%d: unknown event %s\n", path, line, event);
+            exit(1);
+        }
+        if (!strcmp(position, "centroid"))
+        {
+            r->position = POS_CENTROID;
+        }
+        else if (!strcmp(position, "largest"))
+        {
+            r->position = POS_LARGEST;
+        }
+        else if (!strcmp(position, "hold"))
+        {
+            r->position = POS_HOLD;
+        }
+        else
+        {
+            char *end;
+            r->position = strtol(position, &end, 10);
+            if (*end || (r->position < -3500) || (r->position > 3500))
+            {
+                fprintf(stderr, "%s:%d: position must be -3500 to 3500, centroid, largest or hold\n", path, line);
+                exit(1);
+            }
+        }
+        if ((confidence < 0) || (confidence > 100))
+        {
+            fprintf(stderr, "%s:%d: confidence must be 0 to 100\n", path, line);
+            exit(1);
+        }
+        r->confidence = confidence;
+        count++;
+    }
+    fclose(f);
+    return count;
+}
+
+// Classifies all 256 patterns with the rules. Exits if a pattern matches no rule
+// or a rule asks for the position of a pattern with no black sensors.
+static void Build(const char *path, struct Entry *table)
+{
+    struct Rule rules[MAX_RULES];
+    int count = Load(path, rules);
+    unsigned pattern;
+    for (pattern = 0; pattern < 256; pattern++)
+    {
+        int i;
+        for (i = 0; i < count; i++)
+        {
+            struct Rule *r = &rules[i];
+            if (r->split ? (Runs(pattern) > 1) : ((pattern & r->care) == r->value))
+            {
+                break;
+            }
+        }
+        if (i == count)
+        {
+            fprintf(stderr, "%s: no rule matches %02X; end with an xxxxxxxx rule\n", path, pattern);
+            exit(1);
+        }
+        struct Rule *r = &rules[i];
+        struct Entry *e = &table[pattern];
+        e->event = r->event;
+        e->confidence = r->confidence;
+        e->rule = r->line;
+        if (r->position == POS_HOLD)
+        {
+            e->position = LINE_HOLD;
+        }
+        else if ((r->position == POS_CENTROID) || (r->position == POS_LARGEST))
+        {
+            if (!pattern)
+            {
+                fprintf(stderr, "%s:%d: 00000000 has no black sensors to take a position from\n", path, r->line);
+                exit(1);
+            }
+            e->position = Centroid((r->position == POS_LARGEST) ? Largest(pattern) : pattern);
+        }
+        else
+        {
+            e->position = r->position;
+        }
+    }
+}
+
+// Writes pattern as 8 binary digits, bit 7 first.
+static void Bits(unsigned pattern, char *text)
+{
+    int i;
+    for (i = 0; i < 8; i++)
+    {
+        text[i] = (pattern >> (7 - i) & 1) ? '1' : '0';
+    }
+    text[8] = 0;
+}
+
+// Prints one entry for people to read.
+static void Describe(const struct Entry *e)
+{
+    if (e->position == LINE_HOLD)
+    {
+        printf("%-13s %6s %4d", eventNames[e->event], "hold", e->confidence);
+    }
+    else
+    {
+        printf("%-13s %6d %4d", eventNames[e->event], e->position, e->confidence);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    static struct Entry table[256], other[256];
+    char bits[9];
+    unsigned pattern;
+    if ((argc == 3) && !strcmp(argv[1], "table"))
+    {
+        Build(argv[2], table);
+        printf("/* LineTable.c\n");
+        printf(" * Generated by Tools/GenLineTable from Tools/LineRules.txt. Don't edit this\n");
+        printf(" * file; change the rules and regenerate it (see Tools/GenLineTable.c).\n");
+        printf(" */\n\n");
+        printf("#include \"msp.h\"\n#include \"LineTable.h\"\n\n");
+        printf("const struct LineClass lineTable[256] =\n{\n");
+        for (pattern = 0; pattern < 256; pattern++)
+        {
+            struct Entry *e = &table[pattern];
+            Bits(pattern, bits);
+            if (e->position == LINE_HOLD)
+            {
+                printf("    { LINE_HOLD, %s, %d }, // %02X %s\n", eventEnums[e->event], e->confidence, pattern, bits);
+            }
+            else
+            {
+                printf("    { %d, %s, %d }, // %02X %s\n", e->position, eventEnums[e->event], e->confidence, pattern, bits);
+            }
+        }
+        printf("};\n");
+        return 0;
+    }
+    if ((argc == 3) && !strcmp(argv[1], "dump"))
+    {
+        Build(argv[2], table);
+        printf("hex bits     event         position conf rule\n");
+        for (pattern = 0; pattern < 256; pattern++)
+        {
+            Bits(pattern, bits);
+            printf("%02X  %s ", pattern, bits);
+            Describe(&table[pattern]);
+            printf("  %d\n", table[pattern].rule);
+        }
+        return 0;
+    }
+    if ((argc == 4) && !strcmp(argv[1], "diff"))
+    {
+        int changes = 0;
+        Build(argv[2], other);
+        Build(argv[3], table);
+        for (pattern = 0; pattern < 256; pattern++)
+        {
+            struct Entry *a = &other[pattern], *b = &table[pattern];
+            if ((a->event != b->event) || (a->position != b->position) || (a->confidence != b->confidence))
+            {
+                Bits(pattern, bits);
+                printf("%02X  %s  ", pattern, bits);
+                Describe(a);
+                printf("  ->  ");
+                Describe(b);
+                printf("\n");
+                changes++;
+            }
+        }
+        printf("%d of 256 patterns changed\n", changes);
+        return changes != 0;
+    }
+    fprintf(stderr, "usage: %s table RULES > LineTable.c\n"
+            "       %s dump RULES\n"
+            "       %s diff OLD-RULES NEW-RULES\n", argv[0], argv[0], argv[0]);
+    return 2;
+}
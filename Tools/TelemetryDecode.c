@@ -0,0 +1,116 @@
+/* TelemetryDecode.c
+ * Host tool that turns the telemetry frames the robot streams on its
+ * serial port (see Telemetry.h) into CSV, one row per frame.
+ *
+ * Build:  gcc -o TelemetryDecode Tools/TelemetryDecode.c
+ * Use:    ./TelemetryDecode capture.bin > run.csv
+ *         ./TelemetryDecode < /dev/ttyACM0 > run.csv
+ *
+ * Capture the port raw at 115200 baud, for example:
+ *         stty -F /dev/ttyACM0 115200 raw
+ *         cat /dev/ttyACM0 > capture.bin
+ *
+ * Frames with a bad checksum are skipped while the decoder finds the next
+ * sync byte. A summary of frames decoded, dropped (gaps in the sequence
+ * numbers) and corrupt goes to stderr.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+
+#define SYNC 0xA5 // must match TELEMETRY_SYNC in Telemetry.h
+#define FRAME_BYTES 32 // must match TELEMETRY_FRAME_BYTES
+
+static const char *states[] = { "stopped", "running", "win", "solutioning" }; // enum State in Globals.c
+static const char *junctions[] = { "none", "approach", "cross", "T", "left", "right", "end", "gap", "goal" }; // Junction.c
+#define NUM_STATES (sizeof(states) / sizeof(states[0]))
+#define NUM_JUNCTIONS (sizeof(junctions) / sizeof(junctions[0]))
+
+// Returns the little-endian signed 16-bit value at "at".
+static int Int16(const uint8_t *at)
+{
+    return (int16_t)(at[0] | at[1] << 8);
+}
+
+// Prints one frame as a CSV row.
+static void Row(const uint8_t *f)
+{
+    uint32_t time = f[2] | f[3] << 8 | f[4] << 16 | (uint32_t)f[5] << 24;
+    int i;
+    printf("%u,%u,", f[1], time);
+    for (i = 7; i >= 0; i--) // left-most sensor first, as it sits on the robot
+    {
+        putchar((f[6] >> i & 1) ? '1' : '0');
+    }
+    printf(",%s", (f[7] < NUM_STATES) ? states[f[7]] : "?");
+    for (i = 0; i < 8; i++)
+    {
+        printf(",%d", f[8 + i] * 10);
+    }
+    for (i = 16; i < 30; i += 2)
+    {
+        printf(",%d", Int16(&f[i]));
+    }
+    printf(",%s,%d\n", ((f[30] & 0x7F) < NUM_JUNCTIONS) ? junctions[f[30] & 0x7F] : "?", f[30] >> 7);
+}
+
+int main(int argc, char **argv)
+{
+    FILE *in = stdin;
+    uint8_t frame[FRAME_BYTES];
+    int have = 0, c, last = -1;
+    unsigned long frames = 0, dropped = 0, corrupt = 0;
+    if (argc > 2)
+    {
+        fprintf(stderr, "usage: %s [CAPTURE] > CSV\n", argv[0]);
+        return 2;
+    }
+    if ((argc == 2) && !(in = fopen(argv[1], "rb")))
+    {
+        fprintf(stderr, "can't open %s\n", argv[1]);
+        return 1;
+    }
+    printf("sequence,time_us,bits,state,t0_us,t1_us,t2_us,t3_us,t4_us,t5_us,t6_us,t7_us,"
+           "position,left_duty,right_duty,left_speed,right_speed,left_target,right_target,junction,crossing\n");
+    while ((c = getc(in)) != EOF)
+    {
+        if ((have == 0) && (c != SYNC)) // hunting for the start of a frame
+        {
+            continue;
+        }
+        frame[have++] = c;
+        if (have < FRAME_BYTES)
+        {
+            continue;
+        }
+        uint8_t sum = 0;
+        int i;
+        for (i = 0; i < FRAME_BYTES; i++)
+        {
+            sum += frame[i];
+        }
+        if (sum) // not a frame after all; look for a sync byte after the false one
+        {
+            corrupt++;
+            for (i = 1; (i < FRAME_BYTES) && (frame[i] != SYNC); i++)
+            {
+            }
+            have = FRAME_BYTES - i;
+            for (c = 0; c < have; c++)
+            {
+                frame[c] = frame[i + c];
+            }
+            continue;
+        }
+        if (last >= 0)
+        {
+            dropped += (uint8_t)(frame[1] - last - 1);
+        }
+        last = frame[1];
+        Row(frame);
+        frames++;
+        have = 0;
+    }
+    fprintf(stderr, "%lu frames, %lu dropped, %lu corrupt\n", frames, dropped, corrupt);
+    return 0;
+}
@@ -1,21 +1,270 @@
 // Fixed By Umer and Anush
 
 #include "msp.h"
+#include "MotionProfile.h"
 #include "Motor.h"
+#include "Encoder.h"
 #include "Clock.h"
+#include "Timebase.h"
 #include "GenInterrupts.h"
 #include "SysTick.h"
 #include "Globals.c"
 #include "LineSensor.h"
+#include "LineTable.h"
+#include "Junction.h"
+#include "Maze.h"
+#include "Store.h"
 #include "Buttons.h"
 #include "TimerAs.h"
+#include "PID.h"
+#include "Probe.h"
+#include "Scheduler.h"
+#include "OnBoardLEDs.h"
+#include "Telemetry.h"
+#include "Bumpers.h"
+#include "Idle.h"
+#include "LineTurn.h"
+#include "Motion.h"
+#include "RamFunc.h"
+
+#define TURN_CENTER 80 // mm to drive on from where a junction is reported so the wheels are over its middle
+#define TURN_SPEED 300 // wheel speed for spinning at junctions, in mm/s
+#define TRUSTED 50 // patterns with less confidence than this steer on the table's position instead of the measured one
+#define CONTROL_PERIOD 5 // ms between runs of the control task
+
+struct LineSensorSample sample; // the latest line sensor reading
+struct JunctionEvent junction; // the latest report from the junction detector
+int32_t junctionTicks; // both wheels' encoder positions added up, when the junction was reported
+uint8_t crossing; // 1 while driving straight over a junction until it has been classified
+uint8_t turning; // 1 while the motion queue turns the robot at a junction; the line follower waits for it
+struct MotionProfile cruise; // ramps the forward speed on starting and around intersections
+struct Speeds speeds = { MOVE_SPEED, CROSSING_SPEED, SOLUTION_SPEED, SOLUTION_CROSSING_SPEED, CRUISE_ACCEL, CRUISE_JERK };
+int16_t runSpeed = MOVE_SPEED; // forward speed of the current run: speeds.move exploring, speeds.solution replaying
+int16_t crossingSpeed = CROSSING_SPEED; // and the speed for driving over junctions on it
+
+void Task_Sense(void);
+void Task_Speed(void);
+void Task_Control(void);
+void Task_Status(void);
+void Task_Telemetry(void);
+void Turn(uint8_t exits, enum Turn turn);
+void Resume(void);
+void Calibrate(void);
+void Celebrate(void);
+
+// The tasks run while the robot is following the line, highest priority first.
+// Sensing starts a read every 5ms; control runs 3ms later, once the read (2.5ms) has finished,
+// and telemetry logs what control did 1ms after that.
+struct Task tasks[] =
+{
+    { "sense", Task_Sense, 5, 0 },
+    { "speed", Task_Speed, ENCODER_PERIOD_MS, 4 },
+    { "control", Task_Control, CONTROL_PERIOD, 3 },
+    { "telemetry", Task_Telemetry, CONTROL_PERIOD, 4 },
+    { "status", Task_Status, 250, 0 },
+};
+
+// Starts a line sensor read. The result is published by DMA_INT2_IRQHandler.
+void Task_Sense(void)
+{
+    LineSensor_Start();
+}
+
+// Measures the wheel speeds and runs the speed controllers on them.
+// Offset to run 1ms after control so new speed targets take effect straight away.
+RAMFUNC void Task_Speed(void)
+{
+    PROBE_BEGIN(PROBE_SPEED);
+    Encoder_Update();
+    if (turning) // the motion queue has the motors
+    {
+        Motion_Drive();
+    }
+    Motor_VelocityUpdate();
+    PROBE_END(PROBE_SPEED);
+}
+
+// Queues driving on to the middle of a junction and spinning until the sensors are on the way out the maze
+// chose, or turning back at the end of the line. Returns at once; Task_Control follows the line again
+// once the motion queue is done.
+void Turn(uint8_t exits, enum Turn turn)
+{
+    struct MotionCommand center = { MOTION_FORWARD, MOTION_UNTIL_DISTANCE, crossingSpeed, 0 };
+    struct MotionCommand spin = { MOTION_SPIN, MOTION_UNTIL_LINE, TURN_SPEED, 180 };
+    int32_t left, right;
+    if (exits) // at the end of the line there is nothing to center over
+    {
+        Encoder_Read(&left, &right);
+        int32_t travelled = ENCODER_TICKS_TO_MM(left + right - junctionTicks) / 2;
+        if (travelled < TURN_CENTER)
+        {
+            center.amount = TURN_CENTER - travelled;
+            Motion_Enqueue(&center);
+        }
+    }
+    if (turn == TURN_LEFT)
+    {
+        spin.amount = -90;
+    }
+    else if (turn == TURN_RIGHT)
+    {
+        spin.amount = 90;
+    }
+    Motion_Enqueue(&spin);
+    turning = 1;
+}
+
+// Gets ready to follow the line again after the robot has been moved about off it, as by a turn.
+void Resume(void)
+{
+    Junction_Reset(); // the samples from before are of a different line
+    PID_Reset();
+    MotionProfile_Init(&cruise, pidParams.maxSpeed, speeds.accel, speeds.jerk); // pull away again from a standstill
+    MotionProfile_Cruise(&cruise, runSpeed);
+    LineSensor_GetSample(&sample); // act only on samples taken after this
+}
+
+// Sweeps the sensors across the line, 45 degrees either way, to calibrate each channel's white and black.
+// The calibration is kept in the store for solution runs, which skip the sweep. Blocks for about 1.5s.
+void Calibrate(void)
+{
+    struct LineSensorCalibration calibration;
+    SysTick_DisableInterrupt(); // hold the tasks, which can't run while the motors block, so they don't pile up misses
+    LineSensor_CalibrateStart();
+    uint16_t timer = SoftTimer_Start(Task_Sense, 5, 5); // but keep reading the sensors
+    Motor_Spin(-45);
+    Motor_Spin(90);
+    Motor_Spin(-45);
+    SoftTimer_Cancel(timer);
+    if (LineSensor_CalibrateEnd())
+    {
+        LineSensor_GetCalibration(&calibration);
+        Store_Write(STORE_CALIBRATION, &calibration, sizeof(calibration));
+    }
+    Resume();
+    Scheduler_Start(); // start the tasks in step again, on a fresh SysTick period
+    SysTick_Restart();
+    SysTick_EnableInterrupt();
+}
+
+// Flashes the LED green while the robot sits on the goal.
+void Celebrate(void)
+{
+    static uint8_t on;
+    on = !on;
+    OnBoardLEDs_SetColor(on ? LED_GREEN : LED_OFF);
+}
+
+// Steers from the latest line sensor sample and sets the wheel speeds.
+RAMFUNC void Task_Control(void)
+{
+    if (turning) // the motion queue has the motors until the turn is done
+    {
+        LineSensor_GetSample(&sample); // keep up with the sensor, for telemetry
+        if (Motion_Busy())
+        {
+            return;
+        }
+        turning = 0;
+        Motion_Drive(); // the turn's last stop
+        Resume(); // if the turn lost the line, the line follower looks for it
+        return;
+    }
+    uint8_t fresh = 0;
+    while (LineSensor_Next(&sample)) // the junction detector needs every sample, in order
+    {
+        fresh = 1;
+        if (!Junction_Add(&sample, &junction))
+        {
+            continue;
+        }
+        if (junction.type == JUNCTION_APPROACH) // drive straight over it while it is being classified
+        {
+            int32_t left, right;
+            Encoder_Read(&left, &right);
+            junctionTicks = left + right;
+            crossing = 1;
+            MotionProfile_Cruise(&cruise, crossingSpeed);
+        }
+        else if (junction.type == JUNCTION_GOAL)
+        {
+            Motor_SetVelocity(0, 0);
+            if (state == RUNNING)
+            {
+                Maze_Solved(); // what is left of the path is the way here
+            }
+            state = WIN; // main stops the motors and the tasks
+            TimerA1_Start(Celebrate, 15000, 40); // flash for 10s, or until a button is pressed
+            return;
+        }
+        else
+        {
+            crossing = 0;
+            if (junction.type != JUNCTION_GAP) // a gap is just more of the same line, not a choice
+            {
+                enum Turn turn = (state == SOLUTIONING) ? Maze_Replay(junction.exits) : Maze_Explore(junction.exits);
+                if (turn != TURN_STRAIGHT)
+                {
+                    Turn(junction.exits, turn);
+                    return;
+                }
+            }
+            MotionProfile_Cruise(&cruise, runSpeed);
+            PID_Reset(); // the error history is stale after driving blind
+        }
+    }
+    if (!fresh) // if the read didn't finish in time, keep the last speeds
+    {
+        return;
+    }
+    int16_t speed = MotionProfile_Step(&cruise, CONTROL_PERIOD);
+    if (crossing)
+    {
+        Motor_SetVelocity(speed, speed);
+        return;
+    }
+
+    // Follow the black line, steering in proportion to how far it is from the center.
+    PROBE_BEGIN(PROBE_CONTROL);
+    const struct LineClass *pattern = &lineTable[sample.bits]; // what the rules in Tools/LineRules.txt make of this pattern
+    int16_t left, right;
+    int16_t position = sample.position;
+    if ((pattern->confidence < TRUSTED) && (pattern->position != LINE_HOLD)) // stray black sensors would pull the measured position off the line
+    {
+        position = pattern->position;
+    }
+    PID_Step(position, speed, &left, &right);
+    Motor_SetVelocity(left, right);
+    PROBE_END(PROBE_CONTROL);
+}
+
+// Queues a telemetry frame of the latest sample and what the controllers are doing with it.
+void Task_Telemetry(void)
+{
+    struct TelemetryFrame frame;
+    int i;
+    frame.time = sample.time / TIMEBASE_TICKS_PER_US;
+    frame.bits = sample.bits;
+    for (i = 0; i < 8; i++)
+    {
+        frame.times[i] = sample.times[i];
+    }
+    frame.position = sample.position;
+    Motor_GetDuty(&frame.leftDuty, &frame.rightDuty);
+    Encoder_Speed(&frame.leftSpeed, &frame.rightSpeed);
+    Motor_GetVelocity(&frame.leftTarget, &frame.rightTarget);
+    frame.state = state;
+    frame.junction = junction.type;
+    frame.crossing = crossing;
+    Telemetry_Send(&frame);
+}
+
+// Blinks the red LED as a heartbeat while the tasks are running.
+void Task_Status(void)
+{
+    OnBoardLEDs_ToggleRed();
+}
 
-const char *bit_rep[16] = {
-    [ 0] = "0000", [ 1] = "0001", [ 2] = "0010", [ 3] = "0011",
-    [ 4] = "0100", [ 5] = "0101", [ 6] = "0110", [ 7] = "0111",
-    [ 8] = "1000", [ 9] = "1001", [10] = "1010", [11] = "1011",
-    [12] = "1100", [13] = "1101", [14] = "1110", [15] = "1111",
-}; // used to print out a value in binary
 
 // Called when the program starts.
 // Contains the main logic for solving the maze.
@@ -27,75 +276,90 @@ void main(void)
     DisableInterrupts();
     state = STOPPED; // stopped by default
     Clock_Init48MHz(); // run at 48MHz
-    Motor_InitSimple(); // initialize the wheel motors
+    Timebase_Init(); // start the free-running timer that all delays are measured on
+    Probe_Init(); // start the cycle counter used by the timing probes
+    Motor_Init(); // initialize the wheel motors and the PWM timer
+    Encoder_Init(); // start counting wheel encoder ticks
     LineSensor_Init(); // initialize the line/light sensors
+    OnBoardLEDs_Init(); // initialize the LaunchPad LEDs used to show status
+    Telemetry_Init(); // set up the serial port the tasks log to
     OnBoardButtons_Init(); // initialize the on-board buttons for changing the robot's state (running, stopping, solutioning)
-    TimerA0_Init(); // initialize but don't start Timer A0
+    Bumpers_Init(); // cut the motors the moment the robot hits something
+    TimerA1_Init(); // initialize but don't start Timer A1
+    Motion_Init(); // the queue of turns, run on a software timer
+    Store_Init(); // find the calibration and route kept in flash
+    struct LineSensorCalibration calibration;
+    if (Store_Read(STORE_CALIBRATION, &calibration, sizeof(calibration)))
+    {
+        LineSensor_SetCalibration(&calibration);
+    }
+    Maze_Load(); // so the right button can replay a maze solved before the power was cut
+    Scheduler_Init(tasks, sizeof(tasks) / sizeof(tasks[0])); // set up the line-following tasks
     SysTick_Init(); // initialize the SysTick timer with interrupts
+    Idle_Init(); // sleep as deeply as possible whenever there's nothing to do
     EnableInterrupts();
 
+    enum State lastState = STOPPED; // to notice when a button changes the state
     while (1) // forever
-    {   uint8_t sensors = lineSensors; // get the current value of lineSensors in case it is updated mid-loop
-        if (sensors == 0x58) {
-            sensors = 0x18;
-        } else if (sensors == 0x1A){
-            sensors = 0x18;
-        }
-        if ((state == STOPPED)) // if the robot should not be running
-        {
-            SysTick_DisableInterrupt(); // disable the SysTick interrupt
-            lineSensors = 0x18; // so the robot goes forward when enabled instead of moving randomly
-            WaitForInterrupt(); // wait for a button press
-            continue; // in case a non-button interrupt interrupts here, just go back through the while-loop
-        }
-        else if (state == RUNNING) // robot should be solving the maze
+    {
+        OnBoardButtons_Handle(); // act on any button presses
+        struct BumpEvent bump;
+        while (Bumpers_Next(&bump)) // hit something: the bumper interrupt has already halted the motors
         {
-            if (sensors == 0x00) // if the sensors are all white (off the line)
-            {
-                lineSensors = LineSensor_Read(); // re-read the line sensor so that we don't use an outdated value
-            }
-            else if ((sensors == 0xFF) || (sensors == 0x7F) || (sensors == 0xFE) || (sensors == 0x3F)) // if the sensors are all black (T or 4-way intersection)
-            {
-                Motor_ForwardSimple(MOVE_SPEED*1.15, 4);
-            }
-
-            // None of the special if-clauses above were taken, so now just follow the black line.
-            else if ((sensors & 0x80) == 0x80) // if sensor 7 is black
-            {
-                Motor_RightSimple(MOVE_SPEED, 5); // turn left a significant amount
-                Motor_ForwardSimple(MOVE_SPEED, 0.5); // go forward a bit
-            }
-            else if ((sensors & 0x01) == 0x01) // if sensor 0 is black
+            if ((state == RUNNING) || (state == SOLUTIONING))
             {
-                Motor_LeftSimple(MOVE_SPEED, 5); // turn right a significant amount
-                Motor_ForwardSimple(MOVE_SPEED, 0.5); // go forward a bit
+                state = STOPPED; // stay put until a button starts a new run
             }
-            else if ((sensors & 0x40) == 0x40) // if sensor 6 is black
-            {
-                Motor_RightSimple(MOVE_SPEED, 5); // turn left a medium amount
-                Motor_ForwardSimple(MOVE_SPEED, 1); // go forward a bit
-            }
-            else if ((sensors & 0x02) == 0x02) // if sensor 1 is black
+        }
+        if (state != lastState) // starting a run
+        {
+            lastState = state;
+            if (state == RUNNING) // exploring a new maze
             {
-                Motor_LeftSimple(MOVE_SPEED, 5); // turn right a medium amount
-                Motor_ForwardSimple(MOVE_SPEED, 0.5); // go forward a bit
+                Motor_Release(); // drive again after any collision
+                Maze_Reset();
+                runSpeed = speeds.move;
+                crossingSpeed = speeds.moveCrossing;
+                Calibrate(); // on whatever surface this maze is
             }
-            else if ((sensors & 0x04) == 0x04) // if sensor 2 is black
+            else if (state == SOLUTIONING) // replaying the way to the goal found by the last run
             {
-                Motor_LeftSimple(MOVE_SPEED, 5); // turn right a small amount
-                Motor_ForwardSimple(MOVE_SPEED, 0.5); // go forward a bit
+                if (!Maze_StartReplay() && !Maze_Load()) // nothing to replay, even in the store, so explore instead
+                {
+                    state = RUNNING;
+                    continue;
+                }
+                Motor_Release();
+                runSpeed = speeds.solution;
+                crossingSpeed = speeds.solutionCrossing;
             }
-            else if ((sensors & 0x20) == 0x20) // if sensor 5 is black
+            MotionProfile_Cruise(&cruise, runSpeed);
+        }
+        if ((state == STOPPED) || (state == WIN)) // if the robot should not be running
+        {
+            SysTick_DisableInterrupt(); // disable the SysTick interrupt
+            if (Motion_Busy()) // drop the rest of any turn
             {
-                Motor_RightSimple(MOVE_SPEED, 5); // turn left a small amount
-                Motor_ForwardSimple(MOVE_SPEED, 0.5); // go forward a bit
+                Motion_Flush();
             }
-            else if (((sensors & 0x10) == 0x10) || // if sensor 4 is black
-                     ((sensors & 0x08) == 0x08)) // or if sensor 3 is black
+            turning = 0;
+            Motor_StopSimple(); // the controller leaves the motors running between samples
+            OnBoardLEDs_SetRed(0);
+            PID_Reset();
+            crossing = 0;
+            Junction_Reset();
+            MotionProfile_Init(&cruise, pidParams.maxSpeed, speeds.accel, speeds.jerk); // pull away smoothly from a standstill
+            Scheduler_Start(); // so the tasks start in step when the robot is enabled
+            LineSensor_GetSample(&sample); // so the robot only acts on samples taken after it is enabled
+            Idle_Sleep(); // wait for a button press
+            continue; // in case a non-button interrupt interrupts here, just go back through the while-loop
+        }
+        else // RUNNING or SOLUTIONING: following the line through the maze
+        {
+            if (!Scheduler_Run()) // run the next ready task, if there is one
             {
-                Motor_ForwardSimple(MOVE_SPEED, 2);
+                Idle_Sleep(); // sleep until the next SysTick releases more tasks
             }
-            lineSensors = LineSensor_Read();
         }
     }
 }
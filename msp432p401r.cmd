@@ -44,7 +44,9 @@
 
 MEMORY
 {
-    MAIN       (RX) : origin = 0x00000000, length = 0x00040000
+    MAIN       (RX) : origin = 0x00000000, length = 0x0003E000
+    /* The last two 4KB sectors of bank 1 hold Store.c's records; see Flash.h */
+    STORE      (R)  : origin = 0x0003E000, length = 0x00002000
     INFO       (RX) : origin = 0x00200000, length = 0x00004000
 #ifdef  __TI_COMPILER_VERSION__
 #if     __TI_COMPILER_VERSION__ >= 15009000
@@ -128,6 +130,7 @@ SECTIONS
 
 #ifdef  __TI_COMPILER_VERSION__
 #if     __TI_COMPILER_VERSION__ >= 15009000
+    /* RAMFUNC functions (RamFunc.h): stored in flash, copied to SRAM by _c_int00 through .binit */
     .TI.ramfunc : {} load=MAIN, run=SRAM_CODE, table(BINIT)
 #endif
 #endif